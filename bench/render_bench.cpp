@@ -0,0 +1,170 @@
+/*
+*   This program/source code is licensed under the MIT License:
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+*/
+
+
+// Rendering micro-benchmark. Drives display_background(), display_list()
+// (in both list and grid layouts), display_options_bar() and draw_text()
+// into a render target texture on a software renderer (dummy video driver,
+// no window) with synthetic app lists of several sizes, at several window
+// sizes.
+//
+// usage: render_bench [--frames N]
+
+#define SHANNON_NO_MAIN
+#include "../src/main.cpp"
+
+const int bench_app_counts[] = {10, 1000, 10000};
+const SDL_Point bench_sizes[] = {{720, 480}, {1280, 720}, {1920, 1080}};
+const int bench_icon_variants = 16;
+
+SDL_Texture* bench_icons[bench_icon_variants];
+
+void make_icons() {
+    // a handful of distinct icons shared between all the fake apps
+    for (int i = 0; i < bench_icon_variants; i++) {
+        SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, 96, 96, 32, SDL_PIXELFORMAT_ARGB8888);
+        SDL_Rect rect = {0, 0, 96, 96};
+        SDL_FillRect(surface, &rect, 0xFF000000 | (i * 0x0F0A05));
+        rect = {24, 24, 48, 48};
+        SDL_FillRect(surface, &rect, 0xFFFFFFFF - (i * 0x050A0F));
+        bench_icons[i] = icon_texture(surface);
+    }
+}
+
+void make_apps(int count) {
+    store_clear(apps_list);
+
+    for (int i = 0; i < count; i++) {
+        app entry;
+        entry.filename = "Synthetic Benchmark App Number " + std::to_string(i) + ".ipa";
+        entry.filepath = "touchHLE_apps/" + entry.filename;
+        entry.icon = bench_icons[i % bench_icon_variants];
+        store_add(apps_list, entry);
+    }
+
+    apps_count = apps_list.count;
+    rebuild_indices();
+}
+
+// runs `frames` frames of `draw` into target, returns seconds taken
+template <typename F>
+double run_frames(SDL_Texture* target, int frames, F draw) {
+    SDL_SetRenderTarget(renderer, target);
+    profiler.draw_calls = 0;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int f = 0; f < frames; f++) {
+        draw(f);
+        SDL_RenderFlush(renderer);
+    }
+    Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+
+    SDL_SetRenderTarget(renderer, NULL);
+    return (double)elapsed / SDL_GetPerformanceFrequency();
+}
+
+void report(const char* what, int apps, double seconds, int frames) {
+    printf("%-20s %6d apps %5dx%-5d %9.1f fps %9.3f ms/frame %8.1f draws/frame\n",
+           what, apps, width, height, frames / seconds, seconds * 1000 / frames,
+           (double)profiler.draw_calls / frames);
+}
+
+int main(int argc, char* args[]) {
+    int frames = 200;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = args[i];
+        if (arg == "--frames" && i + 1 < argc) {frames = atoi(args[++i]);}
+        else {
+            printf("usage: %s [--frames N]\n", args[0]);
+            return 1;
+        }
+    }
+
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("[!] Error initializing SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // the software renderer needs a surface even though we only draw into targets
+    SDL_Surface *backing = SDL_CreateRGBSurfaceWithFormat(0, 16, 16, 32, SDL_PIXELFORMAT_ARGB8888);
+    renderer = SDL_CreateSoftwareRenderer(backing);
+    if (renderer == NULL) {
+        printf("[!] Error creating renderer: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    load_font();
+    make_icons();
+
+    for (const SDL_Point& size: bench_sizes) {
+        width = size.x;
+        height = size.y;
+        SDL_Texture *target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+
+        double seconds = run_frames(target, frames, [](int) {display_background();});
+        report("display_background", 0, seconds, frames);
+
+        seconds = run_frames(target, frames, [](int f) {
+            draw_text("The quick brown fox jumps over the lazy dog 0123456789", 0, (f * 7) % height);
+        });
+        report("draw_text", 0, seconds, frames);
+
+        for (int count: bench_app_counts) {
+            make_apps(count);
+
+            // hover a row so the underlay gets drawn too
+            x = width / 2;
+            y = 64 * 2 + 8;
+            scroll_jump(list_scroll, 0);
+
+            seconds = run_frames(target, frames, [](int) {display_list();});
+            report("display_list", count, seconds, frames);
+
+            app_layout.mode = LAYOUT_GRID;
+            seconds = run_frames(target, frames, [](int) {display_list();});
+            report("display_list grid", count, seconds, frames);
+            app_layout.mode = LAYOUT_LIST;
+
+            seconds = run_frames(target, frames, [](int) {
+                display_background();
+                display_list();
+                display_options_bar();
+            });
+            report("full frame", count, seconds, frames);
+        }
+
+        SDL_DestroyTexture(target);
+        printf("\n");
+    }
+
+    store_clear(apps_list);
+    row_cache_clear(list_rows);
+    for (SDL_Texture* icon: bench_icons) {SDL_DestroyTexture(icon);}
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(backing);
+    SDL_Quit();
+    return 0;
+}
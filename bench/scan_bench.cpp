@@ -0,0 +1,339 @@
+/*
+*   This program/source code is licensed under the MIT License:
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+*/
+
+
+// Headless benchmark for scan_apps(). Generates a synthetic touchHLE_apps
+// directory full of fake IPAs, then times a cold scan (empty icon cache)
+// and warm scans (icon cache already populated) against a software renderer.
+//
+// usage: scan_bench [--apps N] [--entries N] [--entry-size BYTES] [--art PX] [--no-icons]
+//                   [--xml | --binary] [--stored | --deflate] [--icon-cache qoi|raw]
+//                   [--runs N] [--dir PATH]
+
+#define SHANNON_NO_MAIN
+#include "../src/main.cpp"
+
+#include <cstring>
+#include <fstream>
+
+struct corpus_options {
+    int apps = 200;
+    int entries = 50;       // filler entries per IPA, placed before Info.plist
+    int entry_size = 4096;  // size of each filler entry in bytes
+    int art_size = 512;     // width and height of iTunesArtwork
+    bool icon_files = true; // also ship Icon.png (57px) and Icon@2x.png (114px) listed in CFBundleIconFile
+    bool binary_plist = true;
+    bool deflate = true;
+    int runs = 3;
+    std::string dir = "shannon_bench";
+};
+
+double ticks_to_ms(Uint64 ticks) {
+    return (double)ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+std::string make_xml_plist(const std::vector<std::pair<string, string>>& keys) {
+    std::string out = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                      "<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n"
+                      "<plist version=\"1.0\">\n<dict>\n";
+
+    for (auto& kv: keys) {
+        out += "\t<key>" + kv.first + "</key>\n\t<string>" + kv.second + "</string>\n";
+    }
+
+    out += "</dict>\n</plist>\n";
+    return out;
+}
+
+std::string make_binary_plist(const std::vector<std::pair<string, string>>& keys) {
+    // bplist00 with a single top-level dict of ASCII strings
+    // object 0 is the dict, then every key, then every value
+    std::string out = "bplist00";
+    std::vector<size_t> offsets;
+    int pairs = keys.size();
+
+    auto write_string = [&](const string& str) {
+        offsets.push_back(out.size());
+        if (str.size() < 15) {
+            out += (char)(0x50 | str.size());
+        } else {
+            out += (char)0x5F;
+            out += (char)0x11;
+            out += (char)((str.size() >> 8) & 0xFF);
+            out += (char)(str.size() & 0xFF);
+        }
+        out += str;
+    };
+
+    offsets.push_back(out.size());
+    out += (char)(0xD0 | (pairs < 15 ? pairs : 15));
+    if (pairs >= 15) {out += (char)0x10; out += (char)pairs;}
+    for (int i = 0; i < pairs; i++) {out += (char)(1 + i);}
+    for (int i = 0; i < pairs; i++) {out += (char)(1 + pairs + i);}
+
+    for (auto& kv: keys) {write_string(kv.first);}
+    for (auto& kv: keys) {write_string(kv.second);}
+
+    // offset table uses 2-byte offsets, object refs are 1 byte
+    size_t table_offset = out.size();
+    for (size_t offset: offsets) {
+        out += (char)((offset >> 8) & 0xFF);
+        out += (char)(offset & 0xFF);
+    }
+
+    // 32-byte trailer, all integers big-endian
+    char trailer[32] = {0};
+    Uint64 count = offsets.size();
+    trailer[6] = 2;
+    trailer[7] = 1;
+    for (int i = 0; i < 8; i++) {
+        trailer[8 + i]  = (char)((count >> (56 - i*8)) & 0xFF);
+        trailer[24 + i] = (char)(((Uint64)table_offset >> (56 - i*8)) & 0xFF);
+    }
+    out.append(trailer, 32);
+
+    return out;
+}
+
+bool write_artwork(const std::string& path, int size) {
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL) {return false;}
+
+    // gradient with a bit of noise so the PNG doesn't compress down to nothing
+    Uint32 seed = 1234;
+    for (int py = 0; py < size; py++) {
+        Uint32 *row = (Uint32*)((Uint8*)surface->pixels + py * surface->pitch);
+        for (int px = 0; px < size; px++) {
+            seed = seed * 1103515245 + 12345;
+            Uint8 r = (px * 255) / size;
+            Uint8 g = (py * 255) / size;
+            Uint8 b = (seed >> 16) & 0x3F;
+            row[px] = 0xFF000000 | (r << 16) | (g << 8) | b;
+        }
+    }
+
+    bool ok = IMG_SavePNG(surface, path.c_str()) == 0;
+    SDL_FreeSurface(surface);
+    return ok;
+}
+
+// written into every corpus, so a directory is only ever wiped if the bench made it
+const char* CORPUS_MARKER = ".shannon_bench";
+
+bool generate_corpus(const corpus_options& opts) {
+    std::filesystem::path root = opts.dir;
+    std::filesystem::path apps_dir = root / apps;
+
+    // --dir could point at a real Shannon install; never delete anything the bench didn't generate
+    std::error_code error;
+    if (std::filesystem::exists(root / CORPUS_MARKER, error)) {
+        std::filesystem::remove_all(root);
+    } else if (std::filesystem::exists(root, error) && !std::filesystem::is_empty(root, error)) {
+        printf("[!] %s isn't empty and wasn't made by scan_bench; refusing to overwrite it\n", root.string().c_str());
+        return false;
+    }
+    std::filesystem::create_directories(apps_dir);
+    std::ofstream(root / CORPUS_MARKER) << "generated by scan_bench; this directory is deleted on the next run\n";
+
+    std::string art_path = (root / "artwork.png").string();
+    if (!write_artwork(art_path, opts.art_size)) {
+        printf("[!] Couldn't write artwork: %s\n", IMG_GetError());
+        return false;
+    }
+
+    std::string icon_path = (root / "icon.png").string();
+    std::string icon_2x_path = (root / "icon@2x.png").string();
+    if (!write_artwork(icon_path, 57) || !write_artwork(icon_2x_path, 114)) {
+        printf("[!] Couldn't write icons: %s\n", IMG_GetError());
+        return false;
+    }
+
+    std::vector<char> filler(opts.entry_size);
+    Uint32 seed = 42;
+    for (auto& c: filler) {
+        // half-compressible, somewhere between text and already-compressed assets
+        seed = seed * 1103515245 + 12345;
+        c = (seed >> 16) & 0x0F;
+    }
+
+    int level = opts.deflate ? ZIP_DEFAULT_COMPRESSION_LEVEL : 0;
+
+    for (int i = 0; i < opts.apps; i++) {
+        std::string name = "BenchApp" + std::to_string(i);
+        std::string ipa_path = (apps_dir / (name + ".ipa")).string();
+        std::string bundle = "Payload/" + name + ".app/";
+
+        struct zip_t *zip = zip_open(ipa_path.c_str(), level, 'w');
+        if (zip == NULL) {
+            printf("[!] Couldn't create %s\n", ipa_path.c_str());
+            return false;
+        }
+
+        for (int e = 0; e < opts.entries; e++) {
+            std::string entry = bundle + "res_" + std::to_string(e) + ".dat";
+            zip_entry_open(zip, entry.c_str());
+            zip_entry_write(zip, filler.data(), filler.size());
+            zip_entry_close(zip);
+        }
+
+        std::vector<std::pair<string, string>> keys = {
+            {"CFBundleDisplayName", name},
+            {"CFBundleExecutable", name},
+            {"CFBundleIdentifier", "com.example.bench." + std::to_string(i)},
+            {"CFBundleName", name},
+            {"CFBundleShortVersionString", "1.0"},
+            {"MinimumOSVersion", "3.0"},
+        };
+        if (opts.icon_files) {keys.push_back({"CFBundleIconFile", "Icon.png"});}
+        std::string plist = opts.binary_plist ? make_binary_plist(keys) : make_xml_plist(keys);
+        std::string plist_entry = bundle + "Info.plist";
+        zip_entry_open(zip, plist_entry.c_str());
+        zip_entry_write(zip, plist.data(), plist.size());
+        zip_entry_close(zip);
+
+        if (opts.icon_files) {
+            zip_entry_open(zip, (bundle + "Icon.png").c_str());
+            zip_entry_fwrite(zip, icon_path.c_str());
+            zip_entry_close(zip);
+
+            zip_entry_open(zip, (bundle + "Icon@2x.png").c_str());
+            zip_entry_fwrite(zip, icon_2x_path.c_str());
+            zip_entry_close(zip);
+        }
+
+        zip_entry_open(zip, "iTunesArtwork");
+        zip_entry_fwrite(zip, art_path.c_str());
+        zip_entry_close(zip);
+
+        zip_close(zip);
+    }
+
+    std::filesystem::remove(art_path);
+    std::filesystem::remove(icon_path);
+    std::filesystem::remove(icon_2x_path);
+    return true;
+}
+
+void clear_apps() {
+    for (SDL_Texture* icon: apps_list.icon) {SDL_DestroyTexture(icon);}
+    store_clear(apps_list);
+    apps_count = 0;
+}
+
+void print_scan(const char* label, Uint64 total) {
+    // phases are summed across worker threads, so they can exceed the total
+    double per_app = apps_count > 0 ? ticks_to_ms(total) / apps_count : 0;
+    printf("%-6s total %9.2f ms  (%.3f ms/app, %d apps)\n", label, ticks_to_ms(total), per_app, apps_count);
+    printf("       zip open      %9.2f ms\n", ticks_to_ms(scan_stats.zip_open));
+    printf("       plist locate  %9.2f ms\n", ticks_to_ms(scan_stats.plist_locate));
+    printf("       decode        %9.2f ms\n", ticks_to_ms(scan_stats.decode));
+    printf("       icon resize   %9.2f ms\n", ticks_to_ms(scan_stats.icon_resize));
+    printf("       cache write   %9.2f ms\n", ticks_to_ms(scan_stats.cache_write));
+    printf("       cache load    %9.2f ms\n", ticks_to_ms(scan_stats.cache_load));
+}
+
+Uint64 timed_scan() {
+    clear_apps();
+    reset_scan_stats();
+    Uint64 start = SDL_GetPerformanceCounter();
+    scan_apps();
+    return SDL_GetPerformanceCounter() - start;
+}
+
+int main(int argc, char* args[]) {
+    corpus_options opts;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = args[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--apps" && has_value) {opts.apps = atoi(args[++i]);}
+        else if (arg == "--entries" && has_value) {opts.entries = atoi(args[++i]);}
+        else if (arg == "--entry-size" && has_value) {opts.entry_size = atoi(args[++i]);}
+        else if (arg == "--art" && has_value) {opts.art_size = atoi(args[++i]);}
+        else if (arg == "--no-icons") {opts.icon_files = false;}
+        else if (arg == "--runs" && has_value) {opts.runs = atoi(args[++i]);}
+        else if (arg == "--dir" && has_value) {opts.dir = args[++i];}
+        else if (arg == "--xml") {opts.binary_plist = false;}
+        else if (arg == "--binary") {opts.binary_plist = true;}
+        else if (arg == "--stored") {opts.deflate = false;}
+        else if (arg == "--deflate") {opts.deflate = true;}
+        else if (arg == "--icon-cache" && has_value) {
+            string encoding = args[++i];
+            for (int e = 0; e < ICON_ENCODING_COUNT; e++) {
+                if (encoding == icon_encoding_names[e]) {icon_encoding = e;}
+            }
+        }
+        else {
+            printf("usage: %s [--apps N] [--entries N] [--entry-size BYTES] [--art PX] [--no-icons]\n"
+                   "       [--xml | --binary] [--stored | --deflate] [--icon-cache qoi|raw]\n"
+                   "       [--runs N] [--dir PATH]\n", args[0]);
+            return 1;
+        }
+    }
+
+    // no window: dummy video driver and a software renderer drawing into a plain surface
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("[!] Error initializing SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Surface *target = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    renderer = SDL_CreateSoftwareRenderer(target);
+    if (renderer == NULL) {
+        printf("[!] Error creating renderer: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    printf("generating %d apps (%d x %d byte entries, %dpx artwork%s, %s plist, %s, %s icon cache)\n",
+           opts.apps, opts.entries, opts.entry_size, opts.art_size, opts.icon_files ? " + 57/114px icons" : "",
+           opts.binary_plist ? "binary" : "xml", opts.deflate ? "deflated" : "stored", icon_encoding_names[icon_encoding]);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (!generate_corpus(opts)) {return 1;}
+    printf("corpus generated in %.2f ms\n\n", ticks_to_ms(SDL_GetPerformanceCounter() - start));
+
+    // scan_apps() uses relative paths, so run from inside the corpus
+    std::filesystem::current_path(opts.dir);
+
+    std::filesystem::remove_all(icon_cache);
+    writer_start(icon_writer);
+    print_scan("cold", timed_scan());
+
+    // the cold scan hands its cache files to the background writer; time how long it lags behind
+    start = SDL_GetPerformanceCounter();
+    writer_flush(icon_writer);
+    printf("       writer flush  %9.2f ms after the scan\n", ticks_to_ms(SDL_GetPerformanceCounter() - start));
+
+    for (int run = 0; run < opts.runs; run++) {
+        print_scan("warm", timed_scan());
+    }
+
+    writer_stop(icon_writer);
+    clear_apps();
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,276 @@
+// The app library, stored as parallel arrays rather than a vector of structs.
+// Strings are interned into one contiguous arena and referenced by 32-bit
+// offsets, so equal strings (versions, folders, "Unknown App") are stored
+// once and the per-app arrays the list, search and sort code walk every
+// frame stay small and contiguous. Paths are kept as an interned folder plus
+// a filename, since most apps share a handful of folders.
+//
+// struct app is only used to carry one app's data in and out of the store,
+// e.g. from the scanning threads.
+
+#ifndef SHANNON_APP_STORE_H
+#define SHANNON_APP_STORE_H
+
+#include <SDL2/SDL.h>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// icon previews are a 4x4 grid of ARGB colours, drawn until the real icon is loaded
+const int SWATCH_SIZE = 4;
+const int SWATCH_CELLS = SWATCH_SIZE * SWATCH_SIZE;
+
+struct app {
+    std::string name = "Unknown App";
+    std::string filename;
+    std::string filepath;
+    std::string version = "Unknown";
+    std::string bundle_id;
+    SDL_Texture* icon = NULL;
+    bool has_swatch = false;
+    Uint32 swatch[SWATCH_CELLS] = {0};
+
+    // sort keys
+    std::uintmax_t size = 0;
+    long long added = 0;        // file modification time, seconds
+    long long last_played = 0;  // time(NULL) at last launch, 0 if never
+    int play_count = 0;
+    long long playtime = 0;     // seconds, all sessions
+    bool quick_exit = false;    // last session ended almost immediately
+};
+
+// NUL-terminated strings back to back, with an open-addressed table of offsets for interning
+struct string_arena {
+    std::string data;
+    std::vector<Uint32> slots;  // offset + 1, 0 for empty
+    Uint32 used = 0;
+};
+
+Uint32 arena_hash(std::string_view str) {
+    Uint32 hash = 2166136261u;
+    for (char c: str) {hash = (hash ^ (Uint8)c) * 16777619u;}
+    return hash;
+}
+
+const char* arena_get(const string_arena& arena, Uint32 offset) {
+    return arena.data.c_str() + offset;
+}
+
+void arena_clear(string_arena& arena) {
+    arena.data.clear();
+    arena.slots.assign(1024, 0);
+    arena.used = 0;
+}
+
+void arena_rehash(string_arena& arena, size_t slot_count) {
+    std::vector<Uint32> old;
+    old.swap(arena.slots);
+    arena.slots.assign(slot_count, 0);
+
+    for (Uint32 slot: old) {
+        if (slot == 0) {continue;}
+        Uint32 i = arena_hash(arena_get(arena, slot - 1)) & (slot_count - 1);
+        while (arena.slots[i] != 0) {i = (i + 1) & (slot_count - 1);}
+        arena.slots[i] = slot;
+    }
+}
+
+Uint32 arena_intern(string_arena& arena, std::string_view str) {
+    if (arena.slots.empty()) {arena_clear(arena);}
+    if ((arena.used + 1) * 2 > arena.slots.size()) {arena_rehash(arena, arena.slots.size() * 2);}
+
+    Uint32 mask = arena.slots.size() - 1;
+    Uint32 i = arena_hash(str) & mask;
+
+    while (arena.slots[i] != 0) {
+        const char* existing = arena_get(arena, arena.slots[i] - 1);
+        if (strlen(existing) == str.size() && memcmp(existing, str.data(), str.size()) == 0) {
+            return arena.slots[i] - 1;
+        }
+        i = (i + 1) & mask;
+    }
+
+    Uint32 offset = arena.data.size();
+    arena.data.append(str);
+    arena.data += '\0';
+    arena.slots[i] = offset + 1;
+    arena.used++;
+    return offset;
+}
+
+// offset of str if it's already interned, or -1; never adds anything
+long long arena_find(const string_arena& arena, std::string_view str) {
+    if (arena.slots.empty()) {return -1;}
+
+    Uint32 mask = arena.slots.size() - 1;
+    for (Uint32 i = arena_hash(str) & mask; arena.slots[i] != 0; i = (i + 1) & mask) {
+        const char* existing = arena_get(arena, arena.slots[i] - 1);
+        if (strlen(existing) == str.size() && memcmp(existing, str.data(), str.size()) == 0) {
+            return arena.slots[i] - 1;
+        }
+    }
+    return -1;
+}
+
+enum app_flags {
+    APP_HAS_ICON = 1 << 0,
+    APP_QUICK_EXIT = 1 << 1,
+    APP_HAS_SWATCH = 1 << 2,
+};
+
+struct app_store {
+    string_arena strings;
+    int count = 0;
+
+    // string fields, as arena offsets
+    std::vector<Uint32> name;
+    std::vector<Uint32> filename;
+    std::vector<Uint32> folder;
+    std::vector<Uint32> version;
+    std::vector<Uint32> bundle_id;
+
+    std::vector<SDL_Texture*> icon;
+    std::vector<Uint8> flags;
+    std::vector<Uint32> swatch;     // SWATCH_CELLS per app
+
+    // sort keys
+    std::vector<Uint64> size;
+    std::vector<Sint64> added;
+    std::vector<Sint64> last_played;
+    std::vector<Uint32> play_count;
+    std::vector<Uint32> playtime;
+};
+
+const char* store_str(const app_store& store, Uint32 offset) {
+    return arena_get(store.strings, offset);
+}
+
+std::string store_path(const app_store& store, int i) {
+    return (std::filesystem::path(store_str(store, store.folder[i])) / store_str(store, store.filename[i])).string();
+}
+
+void store_set(app_store& store, int i, const app& entry) {
+    std::filesystem::path path = entry.filepath;
+    store.name[i] = arena_intern(store.strings, entry.name);
+    store.filename[i] = arena_intern(store.strings, path.filename().string());
+    store.folder[i] = arena_intern(store.strings, path.parent_path().string());
+    store.version[i] = arena_intern(store.strings, entry.version);
+    store.bundle_id[i] = arena_intern(store.strings, entry.bundle_id);
+
+    store.icon[i] = entry.icon;
+    store.flags[i] = (entry.icon != NULL ? APP_HAS_ICON : 0) | (entry.quick_exit ? APP_QUICK_EXIT : 0) | (entry.has_swatch ? APP_HAS_SWATCH : 0);
+    memcpy(&store.swatch[i * SWATCH_CELLS], entry.swatch, sizeof(entry.swatch));
+
+    store.size[i] = entry.size;
+    store.added[i] = entry.added;
+    store.last_played[i] = entry.last_played;
+    store.play_count[i] = entry.play_count;
+    store.playtime[i] = entry.playtime;
+}
+
+int store_add(app_store& store, const app& entry) {
+    int i = store.count++;
+    store.name.push_back(0);
+    store.filename.push_back(0);
+    store.folder.push_back(0);
+    store.version.push_back(0);
+    store.bundle_id.push_back(0);
+    store.icon.push_back(NULL);
+    store.flags.push_back(0);
+    store.swatch.resize(store.swatch.size() + SWATCH_CELLS);
+    store.size.push_back(0);
+    store.added.push_back(0);
+    store.last_played.push_back(0);
+    store.play_count.push_back(0);
+    store.playtime.push_back(0);
+
+    store_set(store, i, entry);
+    return i;
+}
+
+app store_get(const app_store& store, int i) {
+    app entry;
+    entry.name = store_str(store, store.name[i]);
+    entry.filename = store_str(store, store.filename[i]);
+    entry.filepath = store_path(store, i);
+    entry.version = store_str(store, store.version[i]);
+    entry.bundle_id = store_str(store, store.bundle_id[i]);
+    entry.icon = store.icon[i];
+    entry.has_swatch = store.flags[i] & APP_HAS_SWATCH;
+    memcpy(entry.swatch, &store.swatch[i * SWATCH_CELLS], sizeof(entry.swatch));
+    entry.size = store.size[i];
+    entry.added = store.added[i];
+    entry.last_played = store.last_played[i];
+    entry.play_count = store.play_count[i];
+    entry.playtime = store.playtime[i];
+    entry.quick_exit = store.flags[i] & APP_QUICK_EXIT;
+    return entry;
+}
+
+void store_set_icon(app_store& store, int i, SDL_Texture* icon) {
+    store.icon[i] = icon;
+    if (icon != NULL) {store.flags[i] |= APP_HAS_ICON;}
+    else {store.flags[i] &= ~APP_HAS_ICON;}
+}
+
+// returns the index of the app at path, or -1; doesn't intern anything
+int store_find(const app_store& store, const std::string& filepath) {
+    std::filesystem::path path = filepath;
+    long long folder = arena_find(store.strings, path.parent_path().string());
+    long long filename = arena_find(store.strings, path.filename().string());
+    if (folder < 0 || filename < 0) {return -1;}
+
+    for (int i = 0; i < store.count; i++) {
+        if (store.filename[i] == filename && store.folder[i] == folder) {return i;}
+    }
+    return -1;
+}
+
+void store_clear(app_store& store) {
+    store = app_store();
+}
+
+// rebuilds the arena with only the strings still referenced, dropping ones left behind by removals
+void store_compact(app_store& store) {
+    string_arena old;
+    std::swap(old, store.strings);
+    arena_clear(store.strings);
+
+    std::vector<Uint32>* fields[] = {&store.name, &store.filename, &store.folder, &store.version, &store.bundle_id};
+    for (auto field: fields) {
+        for (Uint32& offset: *field) {offset = arena_intern(store.strings, arena_get(old, offset));}
+    }
+}
+
+// moves the last app into slot i; the caller owns (and should free) the removed icon
+void store_remove(app_store& store, int i) {
+    int last = --store.count;
+
+    auto move_last = [&](auto& field) {
+        field[i] = field[last];
+        field.pop_back();
+    };
+    move_last(store.name);
+    move_last(store.filename);
+    move_last(store.folder);
+    move_last(store.version);
+    move_last(store.bundle_id);
+    move_last(store.icon);
+    move_last(store.flags);
+    memmove(&store.swatch[i * SWATCH_CELLS], &store.swatch[last * SWATCH_CELLS], SWATCH_CELLS * sizeof(Uint32));
+    store.swatch.resize(last * SWATCH_CELLS);
+    move_last(store.size);
+    move_last(store.added);
+    move_last(store.last_played);
+    move_last(store.play_count);
+    move_last(store.playtime);
+
+    // the arena only grows, so compact once most of it is garbage
+    if (store.strings.data.size() > 65536 && store.strings.data.size() > (size_t)store.count * 512) {
+        store_compact(store);
+    }
+}
+
+#endif
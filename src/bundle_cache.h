@@ -0,0 +1,286 @@
+// Cache of unpacked app bundles. touchHLE can run a .app directory directly,
+// so for apps that get played more than once we unzip the IPA ahead of time
+// and launch the extracted bundle instead, skipping decompression on every
+// launch. Entries are unpacked in parallel (one zip handle per worker), keyed
+// by a hash of the IPA path, invalidated when the IPA's size or mtime changes,
+// and evicted least-recently-used first once the cache goes over its quota.
+//
+// index lines:  last_used size ipa_size ipa_mtime dir ipa_path
+// ipa_path goes last so it can contain spaces.
+
+#ifndef SHANNON_BUNDLE_CACHE_H
+#define SHANNON_BUNDLE_CACHE_H
+
+#include <zip.h>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "task_pool.h"
+
+// only cache apps launched at least this many times
+const int BUNDLE_CACHE_MIN_PLAYS = 2;
+
+struct bundle_entry {
+    std::string dir;
+    unsigned long long size = 0;        // bytes on disk once extracted
+    unsigned long long ipa_size = 0;
+    long long ipa_mtime = 0;
+    long long last_used = 0;
+};
+
+struct bundle_cache {
+    std::filesystem::path root;
+    unsigned long long quota = 0;       // 0 disables the cache
+    std::unordered_map<std::string, bundle_entry> entries;  // keyed by IPA path
+    std::mutex lock;
+    std::thread worker;                 // at most one extraction in flight
+    std::atomic<bool> busy{false};
+};
+
+long long bundle_file_mtime(const std::filesystem::path& path) {
+    std::error_code err;
+    auto time = std::filesystem::last_write_time(path, err);
+    return err ? 0 : (long long)time.time_since_epoch().count();
+}
+
+std::string bundle_dir_name(const std::string& ipa) {
+    unsigned long long hash = 14695981039346656037ull;
+    for (char c: ipa) {hash = (hash ^ (unsigned char)c) * 1099511628211ull;}
+
+    char name[20];
+    snprintf(name, sizeof(name), "%016llx", hash);
+    return name;
+}
+
+// call with cache.lock held
+void bundle_save_index(bundle_cache& cache) {
+    std::string index = (cache.root / "index.txt").string();
+    std::string temp = index + ".tmp";
+
+    std::ofstream file(temp, std::ios::trunc);
+    for (auto& [ipa, entry]: cache.entries) {
+        file << entry.last_used << ' ' << entry.size << ' ' << entry.ipa_size << ' '
+             << entry.ipa_mtime << ' ' << entry.dir << ' ' << ipa << '\n';
+    }
+    file.close();
+
+    std::error_code err;
+    std::filesystem::rename(temp, index, err);
+    if (err) {printf("[!] Error writing %s: %s\n", index.c_str(), err.message().c_str());}
+}
+
+void bundle_cache_load(bundle_cache& cache, const std::filesystem::path& root, unsigned long long quota) {
+    cache.root = root;
+    cache.quota = quota;
+    if (quota == 0) {return;}
+
+    std::filesystem::create_directories(root);
+    std::ifstream file(root / "index.txt");
+    std::string text;
+
+    while (std::getline(file, text)) {
+        std::istringstream line(text);
+        bundle_entry entry;
+        if (!(line >> entry.last_used >> entry.size >> entry.ipa_size >> entry.ipa_mtime >> entry.dir)) {continue;}
+
+        std::string ipa;
+        std::getline(line, ipa);
+        if (!ipa.empty() && ipa[0] == ' ') {ipa.erase(0, 1);}
+        if (!ipa.empty() && ipa.back() == '\r') {ipa.pop_back();}
+        if (ipa.empty() || !std::filesystem::is_directory(root / entry.dir)) {continue;}
+
+        cache.entries[ipa] = entry;
+    }
+
+    // anything in the cache directory the index doesn't know about is a leftover from
+    // an interrupted extraction
+    std::error_code err;
+    for (auto& item: std::filesystem::directory_iterator(root, err)) {
+        if (!item.is_directory()) {continue;}
+
+        bool known = false;
+        for (auto& [ipa, entry]: cache.entries) {
+            if (entry.dir == item.path().filename().string()) {known = true; break;}
+        }
+        if (!known) {std::filesystem::remove_all(item.path(), err);}
+    }
+}
+
+// call with cache.lock held
+void bundle_evict(bundle_cache& cache) {
+    unsigned long long total = 0;
+    for (auto& [ipa, entry]: cache.entries) {total += entry.size;}
+
+    while (total > cache.quota && !cache.entries.empty()) {
+        auto oldest = cache.entries.begin();
+        for (auto it = cache.entries.begin(); it != cache.entries.end(); ++it) {
+            if (it->second.last_used < oldest->second.last_used) {oldest = it;}
+        }
+
+        std::error_code err;
+        std::filesystem::remove_all(cache.root / oldest->second.dir, err);
+        total -= oldest->second.size;
+        cache.entries.erase(oldest);
+    }
+}
+
+// rejects absolute paths and ".." so a malicious IPA can't write outside the cache
+bool bundle_entry_name_safe(const std::string& name) {
+    if (name.empty() || name[0] == '/' || name[0] == '\\' || name.find(':') != std::string::npos) {return false;}
+
+    for (auto& part: std::filesystem::path(name)) {
+        if (part == "..") {return false;}
+    }
+    return true;
+}
+
+// unpacks ipa into dest, splitting the entries across worker threads that each
+// open their own handle on the archive. returns the number of bytes written, or -1
+long long bundle_extract(const std::string& ipa, const std::filesystem::path& dest) {
+    struct zip_t* zip = zip_open(ipa.c_str(), 0, 'r');
+    if (zip == NULL) {return -1;}
+    long long total = zip_entries_total(zip);
+    zip_close(zip);
+    if (total <= 0) {return -1;}
+
+    int threads = std::min(pool_default_threads(), (int)total);
+    std::atomic<bool> ok{true};
+    std::atomic<long long> bytes{0};
+
+    task_pool pool;
+    pool_start(pool, threads);
+
+    for (int t = 0; t < threads; t++) {
+        pool_push(pool, [&, t] {
+            struct zip_t* zip = zip_open(ipa.c_str(), 0, 'r');
+            if (zip == NULL) {ok = false; return;}
+
+            for (long long i = t; i < total && ok; i += threads) {
+                if (zip_entry_openbyindex(zip, i) < 0) {ok = false; break;}
+
+                std::string name = zip_entry_name(zip);
+                std::filesystem::path out = dest / std::filesystem::u8path(name);
+                std::error_code err;
+
+                if (!bundle_entry_name_safe(name)) {
+                    ok = false;
+                } else if (zip_entry_isdir(zip)) {
+                    std::filesystem::create_directories(out, err);
+                } else {
+                    std::filesystem::create_directories(out.parent_path(), err);
+                    if (zip_entry_fread(zip, out.string().c_str()) < 0) {ok = false;}
+                    bytes += zip_entry_size(zip);
+                }
+
+                zip_entry_close(zip);
+            }
+
+            zip_close(zip);
+        });
+    }
+
+    pool_wait_idle(pool);
+    pool_stop(pool);
+
+    return ok ? bytes.load() : -1;
+}
+
+// the .app directory to hand to touchHLE, or "" if this IPA isn't cached (or the
+// cached copy is out of date)
+std::string bundle_cache_lookup(bundle_cache& cache, const std::string& ipa) {
+    if (cache.quota == 0) {return "";}
+    std::lock_guard<std::mutex> guard(cache.lock);
+
+    auto found = cache.entries.find(ipa);
+    if (found == cache.entries.end()) {return "";}
+    bundle_entry& entry = found->second;
+
+    std::error_code err;
+    unsigned long long ipa_size = std::filesystem::file_size(ipa, err);
+    if (err || ipa_size != entry.ipa_size || bundle_file_mtime(ipa) != entry.ipa_mtime) {
+        std::filesystem::remove_all(cache.root / entry.dir, err);
+        cache.entries.erase(found);
+        bundle_save_index(cache);
+        return "";
+    }
+
+    std::filesystem::path payload = cache.root / entry.dir / "Payload";
+    for (auto& item: std::filesystem::directory_iterator(payload, err)) {
+        if (item.is_directory() && item.path().extension() == ".app") {
+            entry.last_used = time(NULL);
+            bundle_save_index(cache);
+            return item.path().string();
+        }
+    }
+
+    return "";
+}
+
+// extracts ipa in the background if it isn't cached yet. only one extraction runs
+// at a time; a request made while one is running is dropped and comes around again
+// on the app's next launch
+void bundle_cache_request(bundle_cache& cache, const std::string& ipa) {
+    if (cache.quota == 0 || cache.busy) {return;}
+    {
+        std::lock_guard<std::mutex> guard(cache.lock);
+        if (cache.entries.count(ipa)) {return;}
+    }
+
+    if (cache.worker.joinable()) {cache.worker.join();}
+    cache.busy = true;
+
+    cache.worker = std::thread([&cache, ipa] {
+        bundle_entry entry;
+        entry.dir = bundle_dir_name(ipa);
+
+        std::error_code err;
+        entry.ipa_size = std::filesystem::file_size(ipa, err);
+        entry.ipa_mtime = bundle_file_mtime(ipa);
+
+        // unpack next to the final location and rename, so a half-written bundle is never used
+        std::filesystem::path temp = cache.root / (entry.dir + ".part");
+        std::filesystem::path final_dir = cache.root / entry.dir;
+        std::filesystem::remove_all(temp, err);
+
+        long long bytes = err ? -1 : bundle_extract(ipa, temp);
+        if (bytes < 0 || (unsigned long long)bytes > cache.quota) {
+            if (bytes < 0) {printf("[!] Error unpacking %s into the app cache\n", ipa.c_str());}
+            std::filesystem::remove_all(temp, err);
+            cache.busy = false;
+            return;
+        }
+
+        std::filesystem::remove_all(final_dir, err);
+        std::filesystem::rename(temp, final_dir, err);
+        if (err) {
+            printf("[!] Error moving %s into the app cache: %s\n", ipa.c_str(), err.message().c_str());
+            std::filesystem::remove_all(temp, err);
+            cache.busy = false;
+            return;
+        }
+
+        entry.size = bytes;
+        entry.last_used = time(NULL);
+
+        {
+            std::lock_guard<std::mutex> guard(cache.lock);
+            cache.entries[ipa] = entry;
+            bundle_evict(cache);
+            bundle_save_index(cache);
+        }
+        cache.busy = false;
+    });
+}
+
+void bundle_cache_close(bundle_cache& cache) {
+    if (cache.worker.joinable()) {cache.worker.join();}
+}
+
+#endif
@@ -0,0 +1,170 @@
+// Background writer for the icon cache. Extraction workers hand over encoded
+// files and carry on; one thread writes them out in batches, each to a temp
+// file that's renamed over the real name, so a crash mid-write never leaves a
+// truncated cache file behind. Files still waiting to be written can be read
+// back with writer_pending(), so a lookup never misses just because the
+// writer is behind. Pushing the same path twice only writes the latest data.
+// writer_forget() and writer_move() drop or re-key one file's queued write
+// without waiting for the rest of the queue, for caches whose app went away
+// or was renamed.
+
+#ifndef SHANNON_CACHE_WRITER_H
+#define SHANNON_CACHE_WRITER_H
+
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct cache_writer {
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable idle;   // signalled after each batch
+    std::unordered_map<std::string, std::vector<Uint8>> pending;
+    std::unordered_map<std::string, std::vector<Uint8>> writing;   // the batch on its way to disk
+    std::string current;                    // the file being written right now, taken out of writing
+    std::vector<Uint8> current_data;
+    bool current_moved = false;             // forgotten or moved while it was written...
+    std::string current_destination;        // ...to here, or nowhere if empty
+    bool busy = false;                      // a batch is being written
+    bool stopping = false;
+};
+
+bool writer_write_file(const std::string& path, const std::vector<Uint8>& data) {
+    std::string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (file == NULL) {return false;}
+
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = fclose(file) == 0 && ok;
+
+    std::error_code err;
+    if (ok) {std::filesystem::rename(temp, path, err);}
+    if (!ok || err) {
+        std::filesystem::remove(temp, err);
+        return false;
+    }
+    return true;
+}
+
+void writer_worker(cache_writer& writer) {
+    std::unique_lock<std::mutex> guard(writer.lock);
+
+    while (true) {
+        writer.wake.wait(guard, [&] {return writer.stopping || !writer.pending.empty();});
+        if (writer.pending.empty()) {return;}
+
+        // take everything queued so far as one batch; lookups still see it in writing. files are
+        // taken out one at a time, so forgetting or moving one only has to wait for the lock
+        writer.writing.swap(writer.pending);
+        writer.busy = true;
+
+        while (!writer.writing.empty()) {
+            auto next = writer.writing.begin();
+            std::string path = next->first;
+            writer.current = path;
+            writer.current_data = std::move(next->second);
+            writer.current_moved = false;
+            writer.writing.erase(next);
+            guard.unlock();
+
+            bool ok = writer_write_file(path, writer.current_data);
+
+            guard.lock();
+            if (!ok) {printf("[!] Error writing %s\n", path.c_str());}
+
+            // it was forgotten or moved while on its way, so follow up on disk
+            std::error_code err;
+            if (ok && writer.current_moved && writer.current_destination.empty()) {std::filesystem::remove(path, err);}
+            if (ok && writer.current_moved && !writer.current_destination.empty()) {std::filesystem::rename(path, writer.current_destination, err);}
+
+            writer.current.clear();
+            writer.current_data.clear();
+        }
+        writer.busy = false;
+        writer.idle.notify_all();
+    }
+}
+
+void writer_start(cache_writer& writer) {
+    writer.stopping = false;
+    writer.worker = std::thread(writer_worker, std::ref(writer));
+}
+
+void writer_push(cache_writer& writer, const std::string& path, std::vector<Uint8> data) {
+    {
+        std::lock_guard<std::mutex> guard(writer.lock);
+        writer.pending[path] = std::move(data);
+    }
+    writer.wake.notify_one();
+}
+
+// copies out data for path if it's still waiting to be written
+bool writer_pending(cache_writer& writer, const std::string& path, std::vector<Uint8>& data) {
+    std::lock_guard<std::mutex> guard(writer.lock);
+    for (auto* queue: {&writer.pending, &writer.writing}) {
+        auto found = queue->find(path);
+        if (found != queue->end()) {
+            data = found->second;
+            return true;
+        }
+    }
+    if (!writer.current.empty() && writer.current == path) {
+        data = writer.current_data;
+        return true;
+    }
+    return false;
+}
+
+// drops the queued write of path, if there is one; a write already underway is deleted once it lands
+void writer_forget(cache_writer& writer, const std::string& path) {
+    std::lock_guard<std::mutex> guard(writer.lock);
+    writer.pending.erase(path);
+    writer.writing.erase(path);
+    if (!writer.current.empty() && writer.current == path) {
+        writer.current.clear();
+        writer.current_moved = true;
+        writer.current_destination.clear();
+    }
+}
+
+// makes the queued write of from go to to instead; a write already underway is renamed once it lands
+void writer_move(cache_writer& writer, const std::string& from, const std::string& to) {
+    std::lock_guard<std::mutex> guard(writer.lock);
+    for (auto* queue: {&writer.pending, &writer.writing}) {
+        auto found = queue->find(from);
+        if (found == queue->end()) {continue;}
+        std::vector<Uint8> data = std::move(found->second);
+        queue->erase(found);
+        (*queue)[to] = std::move(data);
+    }
+    if (!writer.current.empty() && writer.current == from) {
+        writer.current = to;
+        writer.current_moved = true;
+        writer.current_destination = to;
+    }
+}
+
+// waits until everything pushed so far is on disk
+void writer_flush(cache_writer& writer) {
+    std::unique_lock<std::mutex> guard(writer.lock);
+    if (!writer.worker.joinable()) {return;}
+    writer.idle.wait(guard, [&] {return writer.pending.empty() && !writer.busy;});
+}
+
+void writer_stop(cache_writer& writer) {
+    {
+        std::lock_guard<std::mutex> guard(writer.lock);
+        writer.stopping = true;
+    }
+    writer.wake.notify_all();
+    if (writer.worker.joinable()) {writer.worker.join();}
+}
+
+#endif
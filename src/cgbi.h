@@ -0,0 +1,188 @@
+// Decoder for Apple's "CgBI" PNG variant, which Xcode's pngcrush turns iOS
+// artwork into and which SDL_image can't read. It's a PNG with an extra CgBI
+// chunk up front, IDAT data that's raw deflate with no zlib header, pixels
+// stored as BGRA instead of RGBA, and colour premultiplied by alpha.
+//
+// SDL has a surface format for BGRA byte order, which on little-endian machines
+// is the same ARGB8888 that resize_icon() works in, so the swizzle costs
+// nothing; what's left is un-premultiplying, four pixels at a time with SSE2.
+
+#ifndef SHANNON_CGBI_H
+#define SHANNON_CGBI_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SHANNON_CGBI_SSE2
+#endif
+
+// miniz.h carries its whole implementation, which is already compiled into zip.c,
+// so declare just the one inflate entry point we need rather than including it
+extern "C" size_t tinfl_decompress_mem_to_mem(void* out_buf, size_t out_buf_len, const void* src_buf, size_t src_buf_len, int flags);
+const size_t CGBI_INFLATE_FAILED = (size_t)-1;
+
+// refuse anything bigger than this rather than trying to allocate it
+const Uint32 CGBI_MAX_SIDE = 4096;
+
+Uint32 cgbi_be32(const Uint8* p) {
+    return ((Uint32)p[0] << 24) | ((Uint32)p[1] << 16) | ((Uint32)p[2] << 8) | p[3];
+}
+
+bool cgbi_is(const Uint8* data, size_t size) {
+    static const Uint8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    return size >= 16 && memcmp(data, signature, 8) == 0 && memcmp(data + 12, "CgBI", 4) == 0;
+}
+
+Uint8 cgbi_paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) {return a;}
+    return pb <= pc ? b : c;
+}
+
+// undoes PNG's per-scanline filters in place. rows are 1 filter byte + stride bytes
+bool cgbi_unfilter(Uint8* data, Uint32 height, size_t stride, int bpp) {
+    Uint8* prev = NULL;
+
+    for (Uint32 y = 0; y < height; y++) {
+        Uint8 filter = data[0];
+        Uint8* row = data + 1;
+
+        for (size_t i = 0; i < stride; i++) {
+            int left = i >= (size_t)bpp ? row[i - bpp] : 0;
+            int up = prev ? prev[i] : 0;
+            int up_left = (prev && i >= (size_t)bpp) ? prev[i - bpp] : 0;
+
+            switch (filter) {
+                case 0: break;
+                case 1: row[i] += left; break;
+                case 2: row[i] += up; break;
+                case 3: row[i] += (left + up) / 2; break;
+                case 4: row[i] += cgbi_paeth(left, up, up_left); break;
+                default: return false;
+            }
+        }
+
+        prev = row;
+        data += stride + 1;
+    }
+
+    return true;
+}
+
+void cgbi_unpremultiply_pixel(Uint8* p) {
+    Uint8 a = p[3];
+    if (a == 255) {return;}
+    if (a == 0) {p[0] = p[1] = p[2] = 0; return;}
+
+    for (int c = 0; c < 3; c++) {
+        p[c] = (Uint8)std::min(255, (p[c] * 255 + a / 2) / a);
+    }
+}
+
+// BGRA premultiplied -> BGRA straight alpha
+void cgbi_unpremultiply(Uint8* pixels, size_t count) {
+    size_t i = 0;
+
+#ifdef SHANNON_CGBI_SSE2
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    const __m128 max = _mm_set1_ps(255.0f);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pixels + i * 4));
+        __m128i alpha = _mm_srli_epi32(v, 24);
+
+        // most icon pixels are opaque, so skip the maths when all four are
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, byte)) == 0xFFFF) {continue;}
+
+        // 255 / alpha, forced to 0 where alpha is 0 so transparent pixels come out black
+        __m128 alpha_f = _mm_cvtepi32_ps(alpha);
+        __m128 zero_mask = _mm_castsi128_ps(_mm_cmpeq_epi32(alpha, _mm_setzero_si128()));
+        __m128 scale = _mm_andnot_ps(zero_mask, _mm_div_ps(max, _mm_max_ps(alpha_f, _mm_set1_ps(1.0f))));
+
+        __m128i out = _mm_slli_epi32(alpha, 24);
+        for (int shift = 0; shift < 24; shift += 8) {
+            __m128i channel = _mm_and_si128(_mm_srl_epi32(v, _mm_cvtsi32_si128(shift)), byte);
+            __m128 value = _mm_min_ps(_mm_mul_ps(_mm_cvtepi32_ps(channel), scale), max);
+            out = _mm_or_si128(out, _mm_sll_epi32(_mm_cvtps_epi32(value), _mm_cvtsi32_si128(shift)));
+        }
+
+        _mm_storeu_si128((__m128i*)(pixels + i * 4), out);
+    }
+#endif
+
+    for (; i < count; i++) {cgbi_unpremultiply_pixel(pixels + i * 4);}
+}
+
+// returns a BGRA32 surface, or NULL if this isn't a CgBI PNG we can handle
+SDL_Surface* cgbi_decode(const Uint8* data, size_t size) {
+    if (!cgbi_is(data, size)) {return NULL;}
+
+    Uint32 width = 0, height = 0;
+    int color_type = -1;
+    std::vector<Uint8> compressed;
+    size_t pos = 8;
+
+    while (pos + 12 <= size) {
+        Uint32 length = cgbi_be32(data + pos);
+        const Uint8* type = data + pos + 4;
+        const Uint8* body = data + pos + 8;
+        if (length > size - pos - 12) {return NULL;}
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (length < 13) {return NULL;}
+            width = cgbi_be32(body);
+            height = cgbi_be32(body + 4);
+            color_type = body[9];
+
+            // 8-bit RGB or RGBA, not interlaced, is all Xcode ever writes
+            if (body[8] != 8 || (color_type != 2 && color_type != 6) || body[12] != 0) {return NULL;}
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), body, body + length);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+
+        pos += 12 + length;
+    }
+
+    if (width == 0 || height == 0 || width > CGBI_MAX_SIDE || height > CGBI_MAX_SIDE || compressed.empty()) {return NULL;}
+
+    int bpp = color_type == 6 ? 4 : 3;
+    size_t stride = (size_t)width * bpp;
+    std::vector<Uint8> raw((stride + 1) * height);
+
+    // flags 0: raw deflate, no zlib header to parse
+    size_t inflated = tinfl_decompress_mem_to_mem(raw.data(), raw.size(), compressed.data(), compressed.size(), 0);
+    if (inflated == CGBI_INFLATE_FAILED || inflated != raw.size()) {return NULL;}
+    if (!cgbi_unfilter(raw.data(), height, stride, bpp)) {return NULL;}
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_BGRA32);
+    if (surface == NULL) {return NULL;}
+
+    for (Uint32 y = 0; y < height; y++) {
+        const Uint8* in = raw.data() + y * (stride + 1) + 1;
+        Uint8* out = (Uint8*)surface->pixels + y * surface->pitch;
+
+        if (bpp == 4) {
+            memcpy(out, in, stride);
+            cgbi_unpremultiply(out, width);
+        } else {
+            for (Uint32 x = 0; x < width; x++) {
+                out[x * 4 + 0] = in[x * 3 + 0];
+                out[x * 4 + 1] = in[x * 3 + 1];
+                out[x * 4 + 2] = in[x * 3 + 2];
+                out[x * 4 + 3] = 255;
+            }
+        }
+    }
+
+    return surface;
+}
+
+#endif
@@ -0,0 +1,82 @@
+// Changed-region tracking for partial redraws. On the software renderer every
+// full frame means clearing, filling and copying the whole window on the CPU,
+// so instead the parts of the window that changed since the last frame are
+// collected here, redrawn with a clip rect and presented on their own.
+//
+// Rectangles that touch are merged, and past DIRTY_MAX_RECTS the new one is
+// merged into whichever existing rectangle grows least, so a busy frame ends
+// up as a few larger regions rather than many tiny redraws.
+
+#ifndef SHANNON_DIRTY_RECTS_H
+#define SHANNON_DIRTY_RECTS_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+const size_t DIRTY_MAX_RECTS = 8;
+
+struct dirty_region {
+    std::vector<SDL_Rect> rects;
+    bool full = true;           // the whole window, e.g. the first frame or after a resize
+};
+
+long long dirty_area(const SDL_Rect& rect) {
+    return (long long)rect.w * rect.h;
+}
+
+// true if a and b overlap or share an edge, i.e. merging them costs nothing extra
+bool dirty_touching(const SDL_Rect& a, const SDL_Rect& b) {
+    return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+void dirty_add(dirty_region& region, SDL_Rect rect) {
+    if (region.full || rect.w <= 0 || rect.h <= 0) {return;}
+
+    // anything this one touches gets folded into it, which can make it touch others
+    for (size_t i = 0; i < region.rects.size(); ) {
+        if (dirty_touching(rect, region.rects[i])) {
+            SDL_UnionRect(&rect, &region.rects[i], &rect);
+            region.rects.erase(region.rects.begin() + i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    if (region.rects.size() < DIRTY_MAX_RECTS) {
+        region.rects.push_back(rect);
+        return;
+    }
+
+    size_t best = 0;
+    long long best_growth = -1;
+    for (size_t i = 0; i < region.rects.size(); i++) {
+        SDL_Rect merged;
+        SDL_UnionRect(&rect, &region.rects[i], &merged);
+        long long growth = dirty_area(merged) - dirty_area(region.rects[i]);
+        if (best_growth < 0 || growth < best_growth) {best = i; best_growth = growth;}
+    }
+    SDL_UnionRect(&rect, &region.rects[best], &region.rects[best]);
+}
+
+void dirty_all(dirty_region& region) {
+    region.full = true;
+    region.rects.clear();
+}
+
+bool dirty_empty(const dirty_region& region) {
+    return !region.full && region.rects.empty();
+}
+
+// the rectangles to redraw this frame, in window coordinates
+std::vector<SDL_Rect> dirty_rects(const dirty_region& region, int width, int height) {
+    if (region.full) {return {SDL_Rect{0, 0, width, height}};}
+    return region.rects;
+}
+
+void dirty_reset(dirty_region& region) {
+    region.full = false;
+    region.rects.clear();
+}
+
+#endif
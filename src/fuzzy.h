@@ -0,0 +1,246 @@
+// fzf-style fuzzy matcher for the launcher search. Each space-separated term
+// of the query has to appear in order (not necessarily adjacent) in one of an
+// app's fields; matches at word starts, camelCase humps and runs of
+// consecutive characters score higher, gaps cost a little. Results come back
+// best first.
+//
+// Before any scoring, a 64-bit "which characters does this app contain" mask
+// rejects most apps with a single AND per app (two per SSE2 instruction), and
+// a query that extends the previous one only rescans the previous matches.
+// Fields are read straight from the app store's string arena; the index itself
+// only keeps the masks, which are updated one app at a time as the store changes.
+
+#ifndef SHANNON_FUZZY_H
+#define SHANNON_FUZZY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "app_store.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SHANNON_FUZZY_SSE2
+#endif
+
+const int FUZZY_FIELDS = 2;
+
+struct fuzzy_index {
+    // ties are broken by the length of the first
+    std::vector<Uint32> app_store::* fields[FUZZY_FIELDS] = {&app_store::name, &app_store::filename};
+    std::vector<uint64_t> masks;
+
+    std::string last_query;
+    std::vector<int> last_matches;   // unsorted, all apps matching last_query
+};
+
+// scoring constants, roughly fzf's
+const int FUZZY_MATCH = 16;
+const int FUZZY_GAP_START = -3;
+const int FUZZY_GAP_EXTEND = -1;
+const int FUZZY_BONUS_BOUNDARY = 8;
+const int FUZZY_BONUS_CAMEL = 7;
+const int FUZZY_BONUS_CONSECUTIVE = 4;
+
+enum fuzzy_class {FUZZY_DELIM, FUZZY_LOWER, FUZZY_UPPER, FUZZY_DIGIT};
+
+fuzzy_class fuzzy_char_class(char c) {
+    if (c >= 'a' && c <= 'z') {return FUZZY_LOWER;}
+    if (c >= 'A' && c <= 'Z') {return FUZZY_UPPER;}
+    if (c >= '0' && c <= '9') {return FUZZY_DIGIT;}
+    if ((unsigned char)c >= 0x80) {return FUZZY_LOWER;}  // treat UTF-8 as letters
+    return FUZZY_DELIM;
+}
+
+uint64_t fuzzy_char_bit(char c) {
+    if (c >= 'A' && c <= 'Z') {c += 'a' - 'A';}
+    if (c >= 'a' && c <= 'z') {return 1ull << (c - 'a');}
+    if (c >= '0' && c <= '9') {return 1ull << (26 + c - '0');}
+    return 1ull << (36 + (unsigned char)c % 28);
+}
+
+uint64_t fuzzy_mask(std::string_view str) {
+    uint64_t mask = 0;
+    for (char c: str) {
+        if (c != ' ') {mask |= fuzzy_char_bit(c);}
+    }
+    return mask;
+}
+
+char fuzzy_lower(char c) {
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+int fuzzy_bonus(fuzzy_class prev, fuzzy_class cur) {
+    if (cur == FUZZY_DELIM) {return 0;}
+    if (prev == FUZZY_DELIM) {return FUZZY_BONUS_BOUNDARY;}
+    if ((prev == FUZZY_LOWER && cur == FUZZY_UPPER) || (prev != FUZZY_DIGIT && cur == FUZZY_DIGIT)) {return FUZZY_BONUS_CAMEL;}
+    return 0;
+}
+
+// score of one lowercase term against one field, or -1 if it isn't a subsequence
+int fuzzy_score_term(std::string_view text, const char* term, int term_len) {
+    int len = text.size();
+    int t = 0, end = -1;
+
+    // forward pass finds where the earliest full match ends...
+    for (int i = 0; i < len; i++) {
+        if (fuzzy_lower(text[i]) == term[t] && ++t == term_len) {end = i + 1; break;}
+    }
+    if (end < 0) {return -1;}
+
+    // ...and a backward pass from there finds the tightest window
+    int start = end - 1;
+    t = term_len - 1;
+    for (int i = end - 1; i >= 0; i--) {
+        if (fuzzy_lower(text[i]) == term[t]) {
+            if (t == 0) {start = i; break;}
+            t--;
+        }
+    }
+
+    int score = 0, consecutive = 0, first_bonus = 0;
+    bool in_gap = false;
+    fuzzy_class prev = start > 0 ? fuzzy_char_class(text[start - 1]) : FUZZY_DELIM;
+    t = 0;
+
+    for (int i = start; i < end; i++) {
+        fuzzy_class cur = fuzzy_char_class(text[i]);
+
+        if (t < term_len && fuzzy_lower(text[i]) == term[t]) {
+            int bonus = fuzzy_bonus(prev, cur);
+            if (consecutive == 0) {
+                first_bonus = bonus;
+            } else {
+                // a run keeps the bonus of the boundary it started on
+                if (bonus >= FUZZY_BONUS_BOUNDARY && bonus > first_bonus) {first_bonus = bonus;}
+                bonus = std::max(std::max(bonus, first_bonus), FUZZY_BONUS_CONSECUTIVE);
+            }
+
+            score += FUZZY_MATCH + (t == 0 ? bonus * 2 : bonus);
+            consecutive++;
+            in_gap = false;
+            t++;
+        } else {
+            score += in_gap ? FUZZY_GAP_EXTEND : FUZZY_GAP_START;
+            consecutive = 0;
+            first_bonus = 0;
+            in_gap = true;
+        }
+
+        prev = cur;
+    }
+
+    return score;
+}
+
+// sets app i's mask from its fields, growing the index if i is new
+void fuzzy_update(fuzzy_index& index, const app_store& store, int i) {
+    if ((int)index.masks.size() <= i) {index.masks.resize(i + 1, 0);}
+    index.masks[i] = 0;
+    for (auto field: index.fields) {index.masks[i] |= fuzzy_mask(store_str(store, (store.*field)[i]));}
+    index.last_query.clear();
+}
+
+// mirrors store_remove(): the last app's mask moves into slot i
+void fuzzy_remove(fuzzy_index& index, int i) {
+    index.masks[i] = index.masks.back();
+    index.masks.pop_back();
+    index.last_query.clear();
+}
+
+void fuzzy_build(fuzzy_index& index, const app_store& store) {
+    index.masks.clear();
+    for (int i = 0; i < store.count; i++) {fuzzy_update(index, store, i);}
+}
+
+// appends every index in [0, count) whose mask has all of need's bits set
+void fuzzy_prefilter(const fuzzy_index& index, uint64_t need, std::vector<int>& out) {
+    const uint64_t* masks = index.masks.data();
+    int count = index.masks.size();
+    int i = 0;
+
+#ifdef SHANNON_FUZZY_SSE2
+    // no 64-bit compare in SSE2, so check both 32-bit halves of (need & ~mask) for zero
+    __m128i need_v = _mm_set1_epi64x((long long)need);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 2 <= count; i += 2) {
+        __m128i mask_v = _mm_loadu_si128((const __m128i*)(masks + i));
+        __m128i missing = _mm_andnot_si128(mask_v, need_v);
+        int hits = _mm_movemask_epi8(_mm_cmpeq_epi32(missing, zero));
+        if ((hits & 0x00FF) == 0x00FF) {out.push_back(i);}
+        if ((hits & 0xFF00) == 0xFF00) {out.push_back(i + 1);}
+    }
+#endif
+
+    for (; i < count; i++) {
+        if ((masks[i] & need) == need) {out.push_back(i);}
+    }
+}
+
+void fuzzy_run(fuzzy_index& index, const app_store& store, const std::string& query, std::vector<int>& out) {
+    // split into lowercase terms
+    std::vector<std::string> terms;
+    std::string needle;
+    for (char c: query) {needle += fuzzy_lower(c);}
+    for (size_t pos = 0; pos < needle.size(); ) {
+        size_t space = needle.find(' ', pos);
+        if (space == std::string::npos) {space = needle.size();}
+        if (space > pos) {terms.push_back(needle.substr(pos, space - pos));}
+        pos = space + 1;
+    }
+
+    out.clear();
+    if (terms.empty()) {
+        index.last_query.clear();
+        index.last_matches.clear();
+        for (size_t i = 0; i < index.masks.size(); i++) {out.push_back(i);}
+        return;
+    }
+
+    // anything matching the longer query also matched the shorter one
+    std::vector<int> candidates;
+    uint64_t need = fuzzy_mask(needle);
+    if (!index.last_query.empty() && needle.compare(0, index.last_query.size(), index.last_query) == 0) {
+        for (int i: index.last_matches) {
+            if ((index.masks[i] & need) == need) {candidates.push_back(i);}
+        }
+    } else {
+        fuzzy_prefilter(index, need, candidates);
+    }
+
+    std::vector<std::pair<int, int>> scored;
+    index.last_matches.clear();
+
+    for (int i: candidates) {
+        int total = 0;
+        for (auto& term: terms) {
+            int best = -1;
+            for (int f = 0; f < FUZZY_FIELDS; f++) {
+                best = std::max(best, fuzzy_score_term(store_str(store, (store.*index.fields[f])[i]), term.data(), term.size()));
+            }
+            if (best < 0) {total = -1; break;}
+            total += best;
+        }
+
+        if (total < 0) {continue;}
+        scored.push_back({total, i});
+        index.last_matches.push_back(i);
+    }
+    index.last_query = needle;
+
+    // best score first, then shorter names, then original order
+    std::sort(scored.begin(), scored.end(), [&](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        if (a.first != b.first) {return a.first > b.first;}
+        size_t len_a = strlen(store_str(store, (store.*index.fields[0])[a.second]));
+        size_t len_b = strlen(store_str(store, (store.*index.fields[0])[b.second]));
+        if (len_a != len_b) {return len_a < len_b;}
+        return a.second < b.second;
+    });
+
+    for (auto& entry: scored) {out.push_back(entry.second);}
+}
+
+#endif
@@ -0,0 +1,429 @@
+// Glyph atlas for draw_text(). Text is decoded as UTF-8 and every character
+// gets a cell in one texture the first time it's drawn at a given size, so a
+// string of any script is still a single batched draw. Printable ASCII is
+// rendered from a signed distance field of the built-in bitmap font (made by
+// tools/font_sdf.cpp at build time), which gives sharp edges at any scale or
+// display density. Other characters come from a bundled 16 pixel bitmap font
+// (res/font_unicode.hex, compiled in by tools/font_unicode.cpp) that covers
+// Latin, Greek, Cyrillic, kana, Hangul and the common CJK ideographs, on every
+// platform. Anything it lacks is rasterised by GDI on Windows, whose font
+// linking finds glyphs in whatever fonts are installed, and drawn as an empty
+// box elsewhere.
+//
+// SDL's renderer can't run a shader to threshold the distance field on the
+// GPU, so that happens here instead, once per glyph and size: each glyph is
+// rasterised at exactly the number of real pixels it's drawn at, with its
+// edges antialiased over one pixel, and the texture is then drawn 1:1.
+//
+// Text stays monospaced: a character is one column wide, or two for East
+// Asian wide characters. Cells are two columns wide and packed into shelves
+// of glyphs the same height, so a freed cell fits any glyph of its size and
+// eviction never fragments the atlas. When a size runs out of room the least
+// recently used glyph of that size is evicted and the generation bumped,
+// which tells the text layout cache that its layouts may point at stale
+// cells; if a new size doesn't fit at all the atlas starts over.
+
+#ifndef SHANNON_GLYPH_ATLAS_H
+#define SHANNON_GLYPH_ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "font_sdf.h"
+#include "font_unicode.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+const int GLYPH_ATLAS_W = 1024;
+const int GLYPH_ATLAS_H = 512;
+const int GLYPH_MIN_PIXELS = 6;     // text smaller than this is drawn from glyphs this tall, scaled down
+const int GLYPH_MAX_PIXELS = 128;   // ...and larger text from glyphs this tall, scaled up
+const Uint32 GLYPH_REPLACEMENT = 0xFFFD;
+
+struct glyph_cell {
+    Uint64 key = 0;             // glyph_key() of the glyph in it
+    SDL_Rect rect;              // two columns wide
+    Uint32 last_used = 0;
+};
+
+struct glyph_shelf {
+    int y = 0, h = 0;
+    int used = 0;               // pixels taken from the left
+};
+
+struct glyph_atlas {
+    SDL_Texture* texture = NULL;
+    int char_w = FONT_SDF_CHAR_W, char_h = FONT_SDF_CHAR_H;    // one column at scale 1
+
+    std::unordered_map<Uint64, int> cells;  // glyph_key() -> cell
+    std::vector<glyph_cell> cell_list;
+    std::vector<glyph_shelf> shelves;       // top to bottom
+    std::vector<Uint32> scratch;            // one cell's pixels
+    Uint32 clock = 0;                       // ticks once per string drawn
+    Uint32 generation = 0;
+    Uint32 resets = 0;
+    bool full = false;                      // a glyph didn't fit; start over before the next string
+
+#ifdef _WIN32
+    HDC dc = NULL;
+    HBITMAP bitmap = NULL;
+    HFONT font = NULL;
+    int font_pixels = 0;
+    Uint32* bits = NULL;
+    int bits_w = 0, bits_h = 0;
+#endif
+};
+
+// decodes the code point at pos and moves pos past it; bad sequences come out as U+FFFD
+Uint32 utf8_next(std::string_view text, size_t& pos) {
+    Uint8 lead = text[pos++];
+    if (lead < 0x80) {return lead;}
+
+    int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (extra < 0 || lead > 0xF4) {return GLYPH_REPLACEMENT;}
+
+    Uint32 code = lead & (0x3F >> extra);
+    for (int i = 0; i < extra; i++) {
+        if (pos >= text.size() || ((Uint8)text[pos] & 0xC0) != 0x80) {return GLYPH_REPLACEMENT;}
+        code = (code << 6) | ((Uint8)text[pos++] & 0x3F);
+    }
+
+    // overlong encodings, surrogates and anything past U+10FFFF
+    static const Uint32 smallest[4] = {0, 0x80, 0x800, 0x10000};
+    if (code < smallest[extra] || (code >= 0xD800 && code <= 0xDFFF) || code > 0x10FFFF) {return GLYPH_REPLACEMENT;}
+    return code;
+}
+
+// East Asian wide and fullwidth characters take two columns
+bool glyph_wide(Uint32 code) {
+    return (code >= 0x1100 && code <= 0x115F) || (code >= 0x2E80 && code <= 0xA4CF && code != 0x303F) ||
+           (code >= 0xAC00 && code <= 0xD7A3) || (code >= 0xF900 && code <= 0xFAFF) ||
+           (code >= 0xFE30 && code <= 0xFE4F) || (code >= 0xFF00 && code <= 0xFF60) ||
+           (code >= 0xFFE0 && code <= 0xFFE6) || (code >= 0x1F300 && code <= 0x1F64F) ||
+           (code >= 0x1F900 && code <= 0x1F9FF) || (code >= 0x20000 && code <= 0x3FFFD);
+}
+
+int text_columns(std::string_view text) {
+    int columns = 0;
+    for (size_t pos = 0; pos < text.size(); ) {columns += glyph_wide(utf8_next(text, pos)) ? 2 : 1;}
+    return columns;
+}
+
+// how many bytes of text fit in the given number of columns, without splitting a character
+size_t utf8_fit(std::string_view text, int columns) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t next = pos;
+        columns -= glyph_wide(utf8_next(text, next)) ? 2 : 1;
+        if (columns < 0) {break;}
+        pos = next;
+    }
+    return pos;
+}
+
+// a glyph's key in the atlas; the same character at another size is another glyph
+Uint64 glyph_key(Uint32 code, int pixels) {
+    return ((Uint64)pixels << 32) | code;
+}
+
+// width of one column of text that's pixels tall
+int glyph_column(int pixels) {
+    return std::max(1, (pixels * FONT_SDF_CHAR_W + FONT_SDF_CHAR_H / 2) / FONT_SDF_CHAR_H);
+}
+
+void atlas_close(glyph_atlas& atlas) {
+    SDL_DestroyTexture(atlas.texture);
+    atlas.texture = NULL;
+    atlas.cells.clear();
+
+#ifdef _WIN32
+    if (atlas.dc != NULL) {DeleteDC(atlas.dc);}
+    if (atlas.bitmap != NULL) {DeleteObject(atlas.bitmap);}
+    if (atlas.font != NULL) {DeleteObject(atlas.font);}
+    atlas.dc = NULL;
+    atlas.bitmap = NULL;
+    atlas.font = NULL;
+    atlas.font_pixels = 0;
+    atlas.bits = NULL;
+    atlas.bits_w = atlas.bits_h = 0;
+#endif
+}
+
+// forgets every glyph but keeps the texture
+void atlas_clear(glyph_atlas& atlas) {
+    atlas.cells.clear();
+    atlas.cell_list.clear();
+    atlas.shelves.clear();
+    atlas.generation++;
+    atlas.resets++;
+    atlas.full = false;
+}
+
+// (re)creates the atlas for renderer
+bool atlas_reset(glyph_atlas& atlas, SDL_Renderer* renderer) {
+    atlas_close(atlas);
+    atlas_clear(atlas);
+
+    atlas.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, GLYPH_ATLAS_W, GLYPH_ATLAS_H);
+    if (atlas.texture == NULL) {
+        printf("[!] Error creating the glyph atlas: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // glyphs are drawn 1:1 unless text is shrunk past GLYPH_MIN_PIXELS or grown past GLYPH_MAX_PIXELS
+    SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(atlas.texture, SDL_ScaleModeLinear);
+    return true;
+}
+
+// distance from x, y (in font pixels) to the edge of ASCII glyph, interpolated from the field
+float sdf_distance(int glyph, float x, float y) {
+    const int glyph_w = FONT_SDF_CHAR_W * FONT_SDF_SCALE;
+    float sx = std::clamp(x * FONT_SDF_SCALE - 0.5f, 0.f, (float)(glyph_w - 1));
+    float sy = std::clamp(y * FONT_SDF_SCALE - 0.5f, 0.f, (float)(FONT_SDF_H - 1));
+    int x0 = (int)sx, y0 = (int)sy;
+    int x1 = std::min(x0 + 1, glyph_w - 1), y1 = std::min(y0 + 1, FONT_SDF_H - 1);
+    float fx = sx - x0, fy = sy - y0;
+
+    const unsigned char* field = font_sdf + glyph * glyph_w;
+    float top = field[y0 * FONT_SDF_W + x0] * (1 - fx) + field[y0 * FONT_SDF_W + x1] * fx;
+    float bottom = field[y1 * FONT_SDF_W + x0] * (1 - fx) + field[y1 * FONT_SDF_W + x1] * fx;
+    return (top * (1 - fy) + bottom * fy - 128) * FONT_SDF_SPREAD / 127;
+}
+
+// index of code in the bundled bitmap font, or -1 if it isn't there
+int unicode_glyph(Uint32 code) {
+    const unsigned int* end = font_unicode_codes + FONT_UNICODE_GLYPHS;
+    const unsigned int* found = std::lower_bound(font_unicode_codes, end, code);
+    return found != end && *found == code ? found - font_unicode_codes : -1;
+}
+
+// how much of the rectangle x0, y0 to x1, y1 (in the bitmap's pixels) a bundled glyph covers, 0 to 1
+float unicode_coverage(const unsigned short* rows, float x0, float y0, float x1, float y1) {
+    float covered = 0;
+    for (int y = std::max(0, (int)y0); y < std::min(FONT_UNICODE_ROWS, (int)ceilf(y1)); y++) {
+        float overlap_y = std::min(y1, y + 1.f) - std::max(y0, (float)y);
+        for (int x = std::max(0, (int)x0); x < std::min(16, (int)ceilf(x1)); x++) {
+            if (rows[y] & (0x8000 >> x)) {covered += (std::min(x1, x + 1.f) - std::max(x0, (float)x)) * overlap_y;}
+        }
+    }
+    return covered / ((x1 - x0) * (y1 - y0));
+}
+
+// draws code into atlas.scratch, a cell w by h, white with alpha
+void glyph_rasterize(glyph_atlas& atlas, Uint32 code, int w, int h) {
+    atlas.scratch.assign(w * h, 0x00FFFFFF);
+    int column = w / 2;
+    int glyph_w = glyph_wide(code) ? w : column;
+
+    if (code >= 32 && code < 127) {
+        // each pixel is as opaque as it is far inside the edge, ramping over one pixel; at the
+        // font's own size pixel centres are a whole font pixel apart, so it comes out exact
+        float step_x = (float)FONT_SDF_CHAR_W / column, step_y = (float)FONT_SDF_CHAR_H / h;
+        float pixels_per_unit = (float)h / FONT_SDF_CHAR_H;
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < column; x++) {
+                float distance = sdf_distance(code - 32, (x + 0.5f) * step_x, (y + 0.5f) * step_y);
+                float coverage = std::clamp(distance * pixels_per_unit + 0.5f, 0.f, 1.f);
+                atlas.scratch[y * w + x] = ((Uint32)lroundf(coverage * 255) << 24) | 0x00FFFFFF;
+            }
+        }
+        return;
+    }
+
+    int found = unicode_glyph(code);
+    if (found >= 0) {
+        // a bitmap pixel is the size of one of the built-in font's, so the two scale alike; glyphs
+        // sit on the bottom of the cell, centred across its columns. Each pixel is as opaque as
+        // the area it covers, which at the font's own size or larger is the same one pixel ramp
+        const unsigned short* rows = font_unicode_rows + found * FONT_UNICODE_ROWS;
+        float step_x = (float)FONT_SDF_CHAR_W / column, step_y = (float)FONT_SDF_CHAR_H / h;
+        float left = (glyph_w / column * FONT_SDF_CHAR_W - font_unicode_widths[found]) / 2.f;
+        float top = FONT_SDF_CHAR_H - FONT_UNICODE_ROWS;
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < glyph_w; x++) {
+                float bx = x * step_x - left, by = y * step_y - top;
+                float coverage = unicode_coverage(rows, bx, by, bx + step_x, by + step_y);
+                atlas.scratch[y * w + x] = ((Uint32)lroundf(std::min(coverage, 1.f) * 255) << 24) | 0x00FFFFFF;
+            }
+        }
+        return;
+    }
+
+#ifdef _WIN32
+    // the bundled font doesn't have it, so try the system's
+    if (atlas.dc == NULL) {
+        atlas.dc = CreateCompatibleDC(NULL);
+        SetTextColor(atlas.dc, RGB(255, 255, 255));
+        SetBkMode(atlas.dc, TRANSPARENT);
+    }
+
+    if (atlas.bits_w != w || atlas.bits_h != h) {
+        BITMAPINFO info = {};
+        info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        info.bmiHeader.biWidth = w;
+        info.bmiHeader.biHeight = -h;   // top-down
+        info.bmiHeader.biPlanes = 1;
+        info.bmiHeader.biBitCount = 32;
+        info.bmiHeader.biCompression = BI_RGB;
+
+        // the old bitmap can only be deleted once it's no longer selected
+        HBITMAP old = atlas.bitmap;
+        atlas.bitmap = CreateDIBSection(atlas.dc, &info, DIB_RGB_COLORS, (void**)&atlas.bits, NULL, 0);
+        if (atlas.bitmap != NULL) {SelectObject(atlas.dc, atlas.bitmap);} else {atlas.bits = NULL;}
+        if (old != NULL) {DeleteObject(old);}
+        atlas.bits_w = w;
+        atlas.bits_h = h;
+    }
+
+    if (atlas.font_pixels != h) {
+        // Tahoma links to the system's CJK fonts, so GDI falls back to those for glyphs it lacks
+        HFONT old = atlas.font;
+        atlas.font = CreateFontW(-(h * 7 / 9), 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
+                                 CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Tahoma");
+        if (atlas.font != NULL) {SelectObject(atlas.dc, atlas.font);}
+        if (old != NULL) {DeleteObject(old);}
+        atlas.font_pixels = h;
+    }
+
+    if (atlas.bits != NULL) {
+        wchar_t utf16[2];
+        int length = 1;
+        if (code >= 0x10000) {
+            utf16[0] = 0xD800 + ((code - 0x10000) >> 10);
+            utf16[1] = 0xDC00 + ((code - 0x10000) & 0x3FF);
+            length = 2;
+        } else {
+            utf16[0] = code;
+        }
+
+        memset(atlas.bits, 0, w * h * sizeof(Uint32));
+        SIZE size;
+        GetTextExtentPoint32W(atlas.dc, utf16, length, &size);
+        TextOutW(atlas.dc, std::max(0, (int)(glyph_w - size.cx) / 2), h / FONT_SDF_CHAR_H, utf16, length);
+        GdiFlush();
+
+        // white text on black, so any channel is the coverage
+        for (int i = 0; i < w * h; i++) {
+            atlas.scratch[i] = ((atlas.bits[i] & 0xFF) << 24) | 0x00FFFFFF;
+        }
+        return;
+    }
+#endif
+
+    // nothing to rasterise it with: an empty box, so it's clear something is there
+    int line = std::max(1, h / FONT_SDF_CHAR_H);
+    int left = line, right = glyph_w - line, top = h / 9, bottom = h - h / 9;
+    for (int y = top; y < bottom; y++) {
+        for (int x = left; x < right; x++) {
+            if (y < top + line || y >= bottom - line || x < left + line || x >= right - line) {atlas.scratch[y * w + x] = 0xFFFFFFFF;}
+        }
+    }
+}
+
+// starts a new string; glyphs it uses won't be evicted until the next one
+void atlas_tick(glyph_atlas& atlas) {
+    if (atlas.full) {atlas_clear(atlas);}
+    atlas.clock++;
+}
+
+void atlas_touch(glyph_atlas& atlas, int cell) {
+    atlas.cell_list[cell].last_used = atlas.clock;
+}
+
+// changes whenever text drawn earlier may be missing glyphs, so anything cached from it
+// (like the list's row strips) should be redrawn
+Uint32 atlas_epoch(const glyph_atlas& atlas) {
+    return atlas.resets + (atlas.full ? 1 : 0);
+}
+
+// a w by h cell for a new glyph: room on a shelf that height, a new shelf, or else the least
+// recently used glyph that size that isn't part of this string. -1 if there's none
+int atlas_place(glyph_atlas& atlas, int w, int h) {
+    glyph_shelf* shelf = NULL;
+    for (glyph_shelf& s: atlas.shelves) {
+        if (s.h == h && s.used + w <= GLYPH_ATLAS_W) {shelf = &s; break;}
+    }
+
+    int bottom = atlas.shelves.empty() ? 0 : atlas.shelves.back().y + atlas.shelves.back().h;
+    if (shelf == NULL && w <= GLYPH_ATLAS_W && bottom + h <= GLYPH_ATLAS_H) {
+        atlas.shelves.push_back({bottom, h, 0});
+        shelf = &atlas.shelves.back();
+    }
+
+    if (shelf != NULL) {
+        glyph_cell cell;
+        cell.rect = {shelf->used, shelf->y, w, h};
+        shelf->used += w;
+        atlas.cell_list.push_back(cell);
+        return atlas.cell_list.size() - 1;
+    }
+
+    int oldest = -1;
+    for (int i = 0; i < (int)atlas.cell_list.size(); i++) {
+        const glyph_cell& cell = atlas.cell_list[i];
+        if (cell.rect.h != h || cell.last_used == atlas.clock) {continue;}
+        if (oldest < 0 || cell.last_used < atlas.cell_list[oldest].last_used) {oldest = i;}
+    }
+
+    if (oldest >= 0) {
+        atlas.cells.erase(atlas.cell_list[oldest].key);
+        atlas.generation++;
+    }
+    return oldest;
+}
+
+// the cell holding code drawn pixels tall, rasterising it first if need be. -1 if the atlas
+// doesn't exist or has no room left for this string
+int atlas_glyph(glyph_atlas& atlas, Uint32 code, int pixels) {
+    if (atlas.texture == NULL) {return -1;}
+    if (code < 32 || code == 127) {code = '?';}
+    pixels = std::clamp(pixels, GLYPH_MIN_PIXELS, GLYPH_MAX_PIXELS);
+
+    Uint64 key = glyph_key(code, pixels);
+    auto found = atlas.cells.find(key);
+    if (found != atlas.cells.end()) {
+        atlas_touch(atlas, found->second);
+        return found->second;
+    }
+
+    int w = glyph_column(pixels) * 2;
+    int cell = atlas_place(atlas, w, pixels);
+    if (cell < 0) {
+        atlas.full = true;
+        return -1;
+    }
+
+    glyph_rasterize(atlas, code, w, pixels);
+    glyph_cell& slot = atlas.cell_list[cell];
+    SDL_UpdateTexture(atlas.texture, &slot.rect, atlas.scratch.data(), w * sizeof(Uint32));
+
+    slot.key = key;
+    atlas.cells[key] = cell;
+    atlas_touch(atlas, cell);
+    return cell;
+}
+
+// the cell's glyph in texture coordinates, columns wide
+SDL_FRect atlas_uv(const glyph_atlas& atlas, int cell, int columns) {
+    const SDL_Rect& rect = atlas.cell_list[cell].rect;
+    SDL_FRect uv;
+    uv.x = (float)rect.x / GLYPH_ATLAS_W;
+    uv.y = (float)rect.y / GLYPH_ATLAS_H;
+    uv.w = (float)(rect.w / 2 * columns) / GLYPH_ATLAS_W;
+    uv.h = (float)rect.h / GLYPH_ATLAS_H;
+    return uv;
+}
+
+#endif
@@ -0,0 +1,304 @@
+// On-disk format for cached icons. PNG's deflate made encoding and decoding
+// the biggest cost of a warm start, so cached icons are stored either as QOI
+// ("Quite OK Image" format, https://qoiformat.org: a run/index/delta encoding
+// that's several times faster than PNG at similar sizes for icons) or as raw
+// pixels compressed with LZ4 (https://github.com/lz4/lz4, block format only:
+// byte-oriented LZ77 whose decoder is little more than memcpy), behind a small
+// versioned header. A file with the wrong magic, version or size is just
+// treated as a cache miss and the icon is extracted again.
+//
+// header, little-endian:  "SHIC" version:u8 encoding:u8 reserved:u16 width:u32 height:u32
+// followed by QOI chunks (without QOI's own header) or one LZ4 block holding
+// width*height ARGB8888 pixels.
+
+#ifndef SHANNON_ICON_CACHE_H
+#define SHANNON_ICON_CACHE_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+enum icon_encoding {ICON_ENCODING_RAW, ICON_ENCODING_QOI, ICON_ENCODING_COUNT};
+const char* icon_encoding_names[ICON_ENCODING_COUNT] = {"raw", "qoi"};
+
+// bump when the layout changes so old caches get rebuilt instead of misread
+const Uint8 ICON_CACHE_VERSION = 2;
+const int ICON_CACHE_HEADER = 16;
+const Uint32 ICON_CACHE_MAX_SIDE = 4096;
+
+void icon_put32(std::vector<Uint8>& out, Uint32 value) {
+    for (int i = 0; i < 4; i++) {out.push_back((value >> (i * 8)) & 0xFF);}
+}
+
+Uint32 icon_get32(const Uint8* p) {
+    return (Uint32)p[0] | ((Uint32)p[1] << 8) | ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+int qoi_hash(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    return (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+}
+
+void qoi_encode(const Uint32* pixels, size_t count, std::vector<Uint8>& out) {
+    Uint32 index[64] = {0};
+    Uint32 prev = 0xFF000000;
+    int run = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        Uint32 px = pixels[i];
+
+        if (px == prev) {
+            run++;
+            if (run == 62 || i == count - 1) {out.push_back(0xC0 | (run - 1)); run = 0;}
+            continue;
+        }
+        if (run > 0) {out.push_back(0xC0 | (run - 1)); run = 0;}
+
+        Uint8 a = px >> 24, r = (px >> 16) & 0xFF, g = (px >> 8) & 0xFF, b = px & 0xFF;
+        int hash = qoi_hash(r, g, b, a);
+
+        if (index[hash] == px) {
+            out.push_back(hash);
+        } else if (a != prev >> 24) {
+            out.insert(out.end(), {0xFF, r, g, b, a});
+        } else {
+            signed char dr = r - ((prev >> 16) & 0xFF);
+            signed char dg = g - ((prev >> 8) & 0xFF);
+            signed char db = b - (prev & 0xFF);
+            signed char dr_dg = dr - dg, db_dg = db - dg;
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                out.push_back(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+            } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                out.push_back(0x80 | (dg + 32));
+                out.push_back(((dr_dg + 8) << 4) | (db_dg + 8));
+            } else {
+                out.insert(out.end(), {0xFE, r, g, b});
+            }
+        }
+
+        index[hash] = px;
+        prev = px;
+    }
+}
+
+bool qoi_decode(const Uint8* data, size_t size, Uint32* pixels, size_t count) {
+    Uint32 index[64] = {0};
+    Uint32 px = 0xFF000000;
+    size_t pos = 0;
+
+    for (size_t i = 0; i < count; ) {
+        if (pos >= size) {return false;}
+        Uint8 op = data[pos++];
+        Uint8 a = px >> 24, r = (px >> 16) & 0xFF, g = (px >> 8) & 0xFF, b = px & 0xFF;
+
+        if (op == 0xFE || op == 0xFF) {
+            int bytes = op == 0xFF ? 4 : 3;
+            if (pos + bytes > size) {return false;}
+            r = data[pos]; g = data[pos + 1]; b = data[pos + 2];
+            if (op == 0xFF) {a = data[pos + 3];}
+            pos += bytes;
+        } else if ((op & 0xC0) == 0x00) {
+            px = index[op];
+            pixels[i++] = px;
+            continue;
+        } else if ((op & 0xC0) == 0x40) {
+            r += ((op >> 4) & 3) - 2;
+            g += ((op >> 2) & 3) - 2;
+            b += (op & 3) - 2;
+        } else if ((op & 0xC0) == 0x80) {
+            if (pos >= size) {return false;}
+            int dg = (op & 0x3F) - 32;
+            Uint8 next = data[pos++];
+            r += dg + (next >> 4) - 8;
+            g += dg;
+            b += dg + (next & 0x0F) - 8;
+        } else {
+            // run of the previous pixel, which is already in the index
+            int run = (op & 0x3F) + 1;
+            if (i + run > count) {return false;}
+            while (run--) {pixels[i++] = px;}
+            continue;
+        }
+
+        px = ((Uint32)a << 24) | ((Uint32)r << 16) | ((Uint32)g << 8) | b;
+        index[qoi_hash(r, g, b, a)] = px;
+        pixels[i++] = px;
+    }
+
+    return true;
+}
+
+// LZ4 block format: sequences of a token (literal count << 4 | match length - 4), more
+// length bytes for either if its nibble is 15, the literals, then a 2-byte offset back into
+// the output. the last sequence is literals only, and covers at least the last 5 bytes
+const int LZ4_HASH_BITS = 12;
+const size_t LZ4_MIN_MATCH = 4;
+const size_t LZ4_END_LITERALS = 5;     // the last bytes are always literals...
+const size_t LZ4_MATCH_LIMIT = 12;     // ...and no match starts this close to the end
+const size_t LZ4_MAX_OFFSET = 65535;
+
+void lz4_put_length(std::vector<Uint8>& out, size_t length) {
+    for (; length >= 255; length -= 255) {out.push_back(255);}
+    out.push_back(length);
+}
+
+// offset 0 means no match, i.e. the last sequence
+void lz4_sequence(std::vector<Uint8>& out, const Uint8* literals, size_t literal_count, size_t offset, size_t match) {
+    size_t match_code = offset != 0 ? match - LZ4_MIN_MATCH : 0;
+    out.push_back((std::min(literal_count, (size_t)15) << 4) | std::min(match_code, (size_t)15));
+    if (literal_count >= 15) {lz4_put_length(out, literal_count - 15);}
+    out.insert(out.end(), literals, literals + literal_count);
+    if (offset == 0) {return;}
+
+    out.push_back(offset & 0xFF);
+    out.push_back(offset >> 8);
+    if (match_code >= 15) {lz4_put_length(out, match_code - 15);}
+}
+
+// greedy single-pass compressor; icons are small enough that a better match search isn't worth it
+void lz4_encode(const Uint8* data, size_t size, std::vector<Uint8>& out) {
+    std::vector<Uint32> table(1 << LZ4_HASH_BITS, 0);  // hash of 4 bytes -> position + 1
+    size_t anchor = 0, pos = 0;
+    size_t limit = size > LZ4_MATCH_LIMIT ? size - LZ4_MATCH_LIMIT : 0;
+
+    while (pos < limit) {
+        Uint32 bytes;
+        memcpy(&bytes, data + pos, 4);
+        Uint32 hash = (bytes * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = pos + 1;
+
+        if (candidate == 0 || pos - (candidate - 1) > LZ4_MAX_OFFSET || memcmp(data + candidate - 1, data + pos, 4) != 0) {
+            pos++;
+            continue;
+        }
+
+        size_t from = candidate - 1;
+        size_t match = LZ4_MIN_MATCH;
+        while (pos + match < size - LZ4_END_LITERALS && data[from + match] == data[pos + match]) {match++;}
+
+        lz4_sequence(out, data + anchor, pos - anchor, pos - from, match);
+        pos += match;
+        anchor = pos;
+    }
+
+    lz4_sequence(out, data + anchor, size - anchor, 0, 0);
+}
+
+bool lz4_get_length(const Uint8* data, size_t size, size_t& pos, size_t& length) {
+    Uint8 byte;
+    do {
+        if (pos >= size) {return false;}
+        byte = data[pos++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// false unless data decompresses to exactly out_size bytes
+bool lz4_decode(const Uint8* data, size_t size, Uint8* out, size_t out_size) {
+    size_t pos = 0, written = 0;
+
+    while (pos < size) {
+        Uint8 token = data[pos++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !lz4_get_length(data, size, pos, literals)) {return false;}
+        if (literals > size - pos || literals > out_size - written) {return false;}
+        std::copy(data + pos, data + pos + literals, out + written);
+        pos += literals;
+        written += literals;
+        if (pos == size) {break;}
+
+        if (size - pos < 2) {return false;}
+        size_t offset = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+        if (offset == 0 || offset > written) {return false;}
+
+        size_t match = (token & 0x0F) + LZ4_MIN_MATCH;
+        if ((token & 0x0F) == 15 && !lz4_get_length(data, size, pos, match)) {return false;}
+        if (match > out_size - written) {return false;}
+
+        // byte by byte, since a match may overlap what it's copying
+        for (size_t i = 0; i < match; i++) {out[written + i] = out[written - offset + i];}
+        written += match;
+    }
+
+    return written == out_size;
+}
+
+// serialises an icon, converting it to ARGB8888 first if it isn't already
+bool icon_cache_encode(SDL_Surface* surface, int encoding, std::vector<Uint8>& out) {
+    SDL_Surface *argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (argb == NULL) {return false;}
+
+    std::vector<Uint32> pixels(argb->w * argb->h);
+    for (int row = 0; row < argb->h; row++) {
+        memcpy(&pixels[row * argb->w], (Uint8*)argb->pixels + row * argb->pitch, argb->w * sizeof(Uint32));
+    }
+
+    out.clear();
+    out.insert(out.end(), {'S', 'H', 'I', 'C', ICON_CACHE_VERSION, (Uint8)encoding, 0, 0});
+    icon_put32(out, argb->w);
+    icon_put32(out, argb->h);
+    SDL_FreeSurface(argb);
+
+    if (encoding == ICON_ENCODING_QOI) {
+        qoi_encode(pixels.data(), pixels.size(), out);
+    } else {
+        std::vector<Uint8> bytes;
+        bytes.reserve(pixels.size() * 4);
+        for (Uint32 px: pixels) {icon_put32(bytes, px);}
+        lz4_encode(bytes.data(), bytes.size(), out);
+    }
+    return true;
+}
+
+// NULL for anything that isn't a current-version cache file
+SDL_Surface* icon_cache_decode(const Uint8* data, size_t size) {
+    if (size < ICON_CACHE_HEADER || memcmp(data, "SHIC", 4) != 0 || data[4] != ICON_CACHE_VERSION) {return NULL;}
+
+    int encoding = data[5];
+    Uint32 w = icon_get32(data + 8);
+    Uint32 h = icon_get32(data + 12);
+    if (encoding >= ICON_ENCODING_COUNT || w == 0 || h == 0 || w > ICON_CACHE_MAX_SIDE || h > ICON_CACHE_MAX_SIDE) {return NULL;}
+
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL) {return NULL;}
+
+    const Uint8* payload = data + ICON_CACHE_HEADER;
+    size_t payload_size = size - ICON_CACHE_HEADER;
+    std::vector<Uint32> pixels(w * h);
+    bool ok;
+
+    if (encoding == ICON_ENCODING_QOI) {
+        ok = qoi_decode(payload, payload_size, pixels.data(), pixels.size());
+    } else {
+        std::vector<Uint8> bytes(pixels.size() * 4);
+        ok = lz4_decode(payload, payload_size, bytes.data(), bytes.size());
+        for (size_t i = 0; ok && i < pixels.size(); i++) {pixels[i] = icon_get32(&bytes[i * 4]);}
+    }
+
+    if (!ok) {SDL_FreeSurface(surface); return NULL;}
+
+    for (Uint32 row = 0; row < h; row++) {
+        memcpy((Uint8*)surface->pixels + row * surface->pitch, &pixels[row * w], w * sizeof(Uint32));
+    }
+    return surface;
+}
+
+SDL_Surface* icon_cache_load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {return NULL;}
+
+    std::vector<Uint8> data;
+    Uint8 chunk[16384];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {data.insert(data.end(), chunk, chunk + read);}
+    fclose(file);
+
+    return icon_cache_decode(data.data(), data.size());
+}
+
+#endif
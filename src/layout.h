@@ -0,0 +1,79 @@
+// Where each app in the list goes on screen. Drawing, hit-testing, icon
+// loading and the partial-redraw tracker all ask this for cell positions, so
+// they can't disagree about what's where. There are two arrangements: the
+// classic one app per 64px row, and a grid of icon tiles with as many columns
+// as fit the window. Cells are laid out row-major from index 0, so the ones in
+// view are always one contiguous range and nothing outside it is ever
+// touched; a frame costs the same with a hundred apps or a hundred thousand.
+
+#ifndef SHANNON_LAYOUT_H
+#define SHANNON_LAYOUT_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+
+enum layout_mode {LAYOUT_LIST, LAYOUT_GRID, LAYOUT_MODE_COUNT};
+
+const int LIST_ROW_HEIGHT = 64;
+const int GRID_TILE_MIN_WIDTH = 112;    // tiles stretch to fill the row from here
+const int GRID_TILE_HEIGHT = 96;
+
+struct list_layout {
+    int mode = LAYOUT_LIST;
+    int columns = 1;
+    int cell_w = 0;
+    int cell_h = LIST_ROW_HEIGHT;
+    int view_h = 0;     // height the cells can use, i.e. above the options bar
+    int count = 0;
+};
+
+void layout_update(list_layout& layout, int width, int view_h, int count) {
+    if (layout.mode == LAYOUT_GRID) {
+        layout.columns = std::max(1, width / GRID_TILE_MIN_WIDTH);
+        layout.cell_h = GRID_TILE_HEIGHT;
+    } else {
+        layout.columns = 1;
+        layout.cell_h = LIST_ROW_HEIGHT;
+    }
+
+    layout.cell_w = width / layout.columns;
+    layout.view_h = view_h;
+    layout.count = count;
+}
+
+float layout_content_height(const list_layout& layout) {
+    int rows = (layout.count + layout.columns - 1) / layout.columns;
+    return (float)rows * layout.cell_h;
+}
+
+// cell index's rectangle in window coordinates, with the list scrolled down by scroll pixels
+SDL_FRect layout_cell(const list_layout& layout, int index, float scroll) {
+    SDL_FRect cell;
+    cell.x = (float)(index % layout.columns) * layout.cell_w;
+    cell.y = (float)(index / layout.columns) * layout.cell_h - scroll;
+    cell.w = layout.cell_w;
+    cell.h = layout.cell_h;
+    return cell;
+}
+
+// the cell under window coordinates x, y, or -1
+int layout_hit(const list_layout& layout, int x, int y, float scroll) {
+    if (x < 0 || y < 0 || y >= layout.view_h || layout.cell_w <= 0) {return -1;}
+
+    int column = x / layout.cell_w;
+    if (column >= layout.columns) {return -1;}
+
+    int index = (int)floor((y + scroll) / layout.cell_h) * layout.columns + column;
+    return index < layout.count ? index : -1;
+}
+
+// the cells at least partly inside a window height pixels tall, last exclusive
+void layout_visible(const list_layout& layout, float scroll, int height, int& first, int& last) {
+    int first_row = std::max(0, (int)floor(scroll / layout.cell_h));
+    int last_row = (int)ceil((scroll + height) / layout.cell_h);
+    first = std::min(layout.count, first_row * layout.columns);
+    last = std::min(layout.count, last_row * layout.columns);
+}
+
+#endif
@@ -27,13 +27,40 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
+#include <ctime>
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
 #include <iostream>
 #include <filesystem>
 #include <string>
 #include <vector>
 #include <algorithm>
-#include "font.h"
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+#include "app_store.h"
+#include "bundle_cache.h"
+#include "cache_writer.h"
+#include "cgbi.h"
+#include "dirty_rects.h"
+#include "fuzzy.h"
+#include "glyph_atlas.h"
+#include "icon_cache.h"
+#include "layout.h"
+#include "play_history.h"
+#include "plist.h"
+#include "prefetch.h"
+#include "profiler.h"
+#include "row_cache.h"
+#include "scroller.h"
+#include "search.h"
+#include "task_pool.h"
+#include "text_layout.h"
+#include "watcher.h"
 
 using std::string;
 
@@ -44,55 +71,168 @@ int width  = 720;
 int height = 480;
 int x, y;
 
-SDL_Surface* font;
-SDL_Texture* font_texture;
+// every glyph drawn so far at every size, ASCII from the font's distance field and the rest
+// rasterised by the system
+glyph_atlas font_atlas;
+// draw_text() lays each string out once, see text_layout.h
+text_cache text_layouts;
 
 // touchHLE-specific stuff
-// TODO: scrape app name, version, and icon instead of just placeholders
-struct app {
-    std::string name = "Unknown App";
-    std::string filename;
-    std::string filepath;
-    std::string version = "Unknown";
-    SDL_Texture* icon;
-};
-
 const std::filesystem::path apps{"touchHLE_apps"};
 const std::filesystem::path icon_cache{"shannon_icon_cache"};
+const std::filesystem::path roots_file{"shannon_dirs.txt"};
+const std::filesystem::path play_log_file{"shannon_play_log.txt"};
+const std::filesystem::path play_stats_file{"shannon_play_stats.txt"};
+const std::filesystem::path bundle_cache_dir{"shannon_app_cache"};
+
+// directories searched (recursively) for IPAs; just touchHLE_apps unless
+// overridden with --apps on the command line or lines in shannon_dirs.txt
+std::vector<std::filesystem::path> app_roots;
 
-std::vector<app> apps_list;
+app_store apps_list;
 int apps_count;
-int scroll_offset = 0;
+// the list scrolls by the pixel rather than by the row, see scroller.h
+scroller list_scroll;
+// one app per row, or a grid of icon tiles (F7); see layout.h
+list_layout app_layout;
+
+// icons are cached as a small mip chain, each level half the size of the next so they can be
+// box-filtered from each other; the one loaded is the smallest that covers an icon's on-screen
+// size in real pixels, so HiDPI displays get sharp icons and nothing is upscaled
+const int ICON_LEVEL_COUNT = 3;
+const int icon_levels[ICON_LEVEL_COUNT] = {48, 96, 192};
+const int ICON_DRAW_SIZE = 57;
+// read by scan workers to decide how big an icon source they need
+std::atomic<int> icon_level{96};
+// real pixels per window pixel, see update_display_scale()
+float display_scale = 1;
+// how new cache files are written (--icon-cache qoi|raw, raw being LZ4-compressed pixels);
+// either kind is read back
+int icon_encoding = ICON_ENCODING_QOI;
+// cache files are written off the extraction workers, see cache_writer.h
+cache_writer icon_writer;
+
+// rows of the app list are drawn once into cached strips and blitted from there, see row_cache.h
+// a few spare strips beyond what fits on screen keep rows that just scrolled out around
+row_cache list_rows;
+const int ROW_CACHE_SPARE = 4;
+
+// type-to-filter search; visible_apps holds the apps_list indices currently shown, in order
+// fuzzy mode ranks by match quality over name and filename, exact mode is a plain substring
+// filter over filename, name and bundle ID that keeps list order; Tab switches between them
+search_index apps_search;
+fuzzy_index apps_fuzzy;
+bool fuzzy_search = true;
+std::string search_query;
+std::vector<int> visible_apps;
+int visible_count;
+
+// every sort mode keeps a precomputed permutation of apps_list, so switching modes (F5) just
+// picks a different one; F6 groups apps by folder first, then by the sort mode
+enum sort_mode {SORT_NAME, SORT_SIZE, SORT_ADDED, SORT_LAST_PLAYED, SORT_PLAY_COUNT, SORT_MODE_COUNT};
+const char* sort_mode_names[SORT_MODE_COUNT] = {"name", "size", "date added", "last played", "play count"};
+int current_sort = SORT_NAME;
+bool group_by_folder = false;
+std::vector<int> sort_orders[SORT_MODE_COUNT];
+
+// picks up IPAs added to/removed from the app roots while we're running, one per root
+std::vector<dir_watcher> apps_watchers;
+
+// watcher snapshots and IPAs added or changed while we're running are read here, off the
+// render thread; update_apps() picks up the results
+task_pool update_pool;
+const int UPDATE_THREADS = 2;
+
+struct app_updates {
+    std::mutex lock;
+    std::vector<std::pair<Uint32, app>> done;   // ticket, entry
+    // render thread only: filepath -> ticket of the newest read, so a read that's been
+    // superseded or whose file has gone since is dropped
+    std::map<std::string, Uint32> waiting;
+    Uint32 next_ticket = 0;
+};
+app_updates pending_updates;
+
+// after WATCH_RESCAN every root is listed again on update_pool, and the list is brought in
+// line with what's there once that's done (see finish_rescan()); until then it stays as it was
+struct app_rescan {
+    std::mutex lock;
+    bool done = false;
+    std::map<std::string, file_stamp> files;   // every IPA, by path
+};
+std::shared_ptr<app_rescan> pending_rescan;
+
+// icons whose cache level is missing are extracted on update_pool too, and their textures made
+// once they're back (see finish_icon_loads()); the row shows its swatch until then
+struct icon_load {
+    std::string filepath;
+    int level;
+    SDL_Surface* surface;
+};
+struct icon_loads {
+    std::mutex lock;
+    std::vector<icon_load> done;
+    std::map<std::string, int> waiting;   // render thread only: filepath -> level being loaded
+};
+icon_loads pending_icons;
 
 bool toggle_pause = false;
 
-void load_font() {
-    Uint32 rmask, gmask, bmask, amask;
-
-    // set color masks based on SDL endianness
-    if (SDL_BYTEORDER == SDL_BIG_ENDIAN) {
-        rmask = 0xff000000;
-        gmask = 0x00ff0000;
-        bmask = 0x0000ff00;
-        amask = 0x000000ff;
-    } else {
-        rmask = 0x000000ff;
-        gmask = 0x0000ff00;
-        bmask = 0x00ff0000;
-        amask = 0xff000000;
-    }
+// partial redraw: on the software renderer only the parts of the window that changed are
+// redrawn and presented (--full-redraw turns this off). the background wave stays still in
+// this mode, since animating it means redrawing everything; --animate-background keeps it moving
+bool partial_redraw = false;
+bool allow_partial_redraw = true;
+bool animate_background = true;
+bool keep_animating = false;
+// --software skips the GPU renderer; it's also used whenever that can't be created
+bool force_software = false;
+dirty_region frame_dirty;
+const Uint32 IDLE_WAIT_MS = 16;
+
+// launch counts, playtime and quick exits, keyed by IPA path
+play_history history;
+
+// warms the IPA under the mouse (after it's been hovered for a bit) and the most
+// recently played ones into the page cache, so launching doesn't start with a cold read
+prefetcher app_prefetch;
+const Uint32 HOVER_DWELL_MS = 400;
+const int PREFETCH_RECENT = 3;
+int hover_app = -1;
+Uint32 hover_since = 0;
+
+// unpacked copies of frequently played IPAs, off unless --app-cache <MB> is given
+bundle_cache app_bundles;
+
+// accumulated per-phase timings for scan_apps(), in performance counter ticks
+// summed over all worker threads, so they can add up to more than the wall time
+// nothing in the launcher reads these, they're here for bench/scan_bench.cpp
+struct scan_timings {
+    std::atomic<Uint64> zip_open{0};
+    std::atomic<Uint64> plist_locate{0};
+    std::atomic<Uint64> decode{0};
+    std::atomic<Uint64> icon_resize{0};
+    std::atomic<Uint64> cache_write{0};
+    std::atomic<Uint64> cache_load{0};
+};
 
-    // clear out font just in case
-    SDL_FreeSurface(font);
-    SDL_DestroyTexture(font_texture);
+scan_timings scan_stats;
 
-    font = SDL_CreateRGBSurfaceFrom((void*)fallback_font.pixel_data, fallback_font.width, fallback_font.height, fallback_font.bytes_per_pixel*8, fallback_font.bytes_per_pixel*fallback_font.width, rmask, gmask, bmask, amask);
-    font_texture = SDL_CreateTextureFromSurface(renderer, font);
+void reset_scan_stats() {
+    scan_stats.zip_open = scan_stats.plist_locate = scan_stats.decode = 0;
+    scan_stats.icon_resize = scan_stats.cache_write = scan_stats.cache_load = 0;
+}
+
+void load_font() {
+    // the built-in fonts are compiled in (see tools/font_sdf.cpp and tools/font_unicode.cpp), so
+    // all there is to load is the atlas their glyphs get rasterised into
+    atlas_reset(font_atlas, renderer);
+    text_cache_clear(text_layouts);
     return;
 }
 
-void draw_text(string text, int x = 0, int y = 0, int scale = 1, int align = 1, int max_width = width, SDL_Color mul = {255, 255, 255}) {
-    // Bitmap monospaced font-drawing function, supports printable ASCII only
+float draw_text(std::string_view text, int x = 0, int y = 0, int scale = 1, int align = 1, int max_width = width, SDL_Color mul = {255, 255, 255}) {
+    // Bitmap monospaced font-drawing function, takes UTF-8
     // ----------------------------------------------------------
     // text: a std string,          e.g. "Hello World"
     // x, y: x and y coordinates,   e.g. "320, 240"
@@ -100,146 +240,448 @@ void draw_text(string text, int x = 0, int y = 0, int scale = 1, int align = 1,
     // align: alignment setting     e.g. 0 for centered, 1 for right-align, -1 for left-align
     // max_width: max width that text can occupy; set to 0 to disable
     // mul: SDL_Color to multiply font texture with (in other words, the text color)
+    // returns the width the text takes up once shrunk to fit, for placing more text after it
 
-    // printable ASCII (use this string for making new fonts):
+    // printable ASCII comes from the bitmap font in font.h (use this string for making new fonts),
+    // which is turned into a distance field at build time so it stays sharp at any size:
     //  !"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\]^_`abcdefghijklmnopqrstuvwxyz{|}~
+    // everything else is rasterised into the glyph atlas the first time it's drawn, see glyph_atlas.h
 
     // skips the entire function if the font happens to have not loaded for whatever reason
     // prevents a crash
-    if (font == NULL) {
-        return;
+    if (font_atlas.texture == NULL) {
+        return 0;
     }
 
-    SDL_SetTextureScaleMode(font_texture, SDL_ScaleModeNearest);
-    SDL_SetTextureColorMod(font_texture, mul.r, mul.g, mul.b);
-    SDL_Rect src;
-    SDL_Rect dest;
+    prof_scope scope(PROF_TEXT);
+    atlas_tick(font_atlas);
 
-    int char_width  = font->w/95;
-    int char_height = font->h;
-    int scaled_char_width = char_width;
-    int text_size = text.size();
+    // glyph positions only depend on these, so they're worked out the first time a string is
+    // drawn this way and reused after that
+    Uint64 key = text_key(text, scale, align, max_width);
+    const text_layout* cached = text_find(text_layouts, key, text, scale, align, max_width, font_atlas.generation);
 
-    // resizes characters if need be
-    if (max_width < text_size * (char_width * scale) && max_width != 0) {
-        scaled_char_width = max_width / text_size;
-    } else {
-        scaled_char_width *= scale;
-    }
+    if (cached == NULL) {
+        text_layout& layout = text_insert(text_layouts, key, text, scale, align, max_width);
+        SDL_FRect dest;
+
+        int char_width  = font_atlas.char_w;
+        int char_height = font_atlas.char_h;
+        int text_size = text_columns(text);   // in columns; wide characters take two
 
-    for (int i = 0; i < text_size; ++i) {
-        // get ASCII value of current character
-        // we also define char properties here due to some resizing shenanagains later
-        int char_value = text[i] - 32;
-        int align_offset = 0;
+        // shrinks text that doesn't fit, keeping its proportions
+        float fit = 1;
+        if (max_width < text_size * (char_width * scale) && max_width != 0) {
+            fit = (float)max_width / (text_size * char_width * scale);
+        }
+        float scaled_char_width = char_width * scale * fit;
+        float scaled_char_height = char_height * scale * fit;
 
-        // get character coords in source image
-        // width and height are 1 character
-        src.x = (char_value * char_width);
-        src.y = 0;
-        src.w = char_width;
-        src.h = char_height;
+        // glyphs are rasterised at the size they cover in real pixels, and shrunk text stays
+        // centred on the line it would have filled, snapped to a real pixel
+        int pixels = std::max(1, (int)lroundf(scaled_char_height * display_scale));
+        float top = roundf((char_height * scale - scaled_char_height) / 2 * display_scale) / display_scale;
 
         // determine offset value to use
+        float align_offset = 0;
         if (align >= 1) {align_offset = 0;}
-        else if (align == 0) {align_offset = ((text_size * scaled_char_width)/2) * -1;}
+        else if (align == 0) {align_offset = roundf(text_size * scaled_char_width / 2) * -1;}
         else if (align <= -1) {align_offset = (text_size * scaled_char_width) * -1;}
 
-        // get x and y coords, offset by current character count and align/scale factors
-        // width and height bound-box get scaled here as well
-        dest.x = x + (i * scaled_char_width) + align_offset;
-        dest.y = y;
-        dest.w = scaled_char_width;
-        dest.h = char_height * scale;
+        int column = 0;
+        for (size_t pos = 0; pos < text.size(); ) {
+            Uint32 code = utf8_next(text, pos);
+            int span = glyph_wide(code) ? 2 : 1;
+            int glyph = atlas_glyph(font_atlas, code, pixels);
+
+            // get coords relative to the text's origin, offset by current column and align/scale factors
+            // width and height bound-box get scaled here as well
+            dest.x = (column * scaled_char_width) + align_offset;
+            dest.y = top;
+            dest.w = scaled_char_width * span;
+            dest.h = scaled_char_height;
+            column += span;
+
+            if (glyph >= 0) {text_add_quad(layout, dest, atlas_uv(font_atlas, glyph, span), glyph);}
+        }
 
-        // skip character if it's out of view
-        if (dest.x > width || dest.x < -dest.w || dest.y > height || dest.y < -dest.h) {continue;}
+        // rasterising may have evicted glyphs, but none of this string's
+        layout.width = text_size * scaled_char_width;
+        layout.generation = font_atlas.generation;
+        cached = &layout;
+    } else {
+        for (int glyph: cached->glyphs) {atlas_touch(font_atlas, glyph);}
+    }
 
-        SDL_RenderCopy(renderer, font_texture, &src, &dest);
+    // skips the whole string if it's out of view; SDL clips anything partly on screen
+    SDL_Color color = {mul.r, mul.g, mul.b, 255};
+    if (text_draw(text_layouts, renderer, font_atlas.texture, *cached, x, y, color, width, height)) {
+        profiler.draw_calls++;
     }
-    return;
+    return cached->width;
 }
 
-void extract_icon(const char* file, const char* name) {
-    int icon_size = 96;
-    struct zip_t *zip = zip_open(file, 0, 'r');
-    zip_entry_open(zip, "iTunesArtwork");
+SDL_Surface* resize_icon(SDL_Surface* source, int size) {
+    // box-filtered downscale on the CPU so icons can be prepared off the render thread
+    // alpha-weighted so transparent edges don't bleed dark fringes into the result
+    SDL_Surface *src = SDL_ConvertSurfaceFormat(source, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (src == NULL) {return NULL;}
+
+    SDL_Surface *dst = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (dst == NULL) {SDL_FreeSurface(src); return NULL;}
+
+    for (int dy = 0; dy < size; dy++) {
+        int y0 = dy * src->h / size;
+        int y1 = std::max(y0 + 1, (dy + 1) * src->h / size);
+        Uint32 *out = (Uint32*)((Uint8*)dst->pixels + dy * dst->pitch);
+
+        for (int dx = 0; dx < size; dx++) {
+            int x0 = dx * src->w / size;
+            int x1 = std::max(x0 + 1, (dx + 1) * src->w / size);
+            Uint64 a = 0, r = 0, g = 0, b = 0;
+
+            for (int sy = y0; sy < y1; sy++) {
+                Uint32 *in = (Uint32*)((Uint8*)src->pixels + sy * src->pitch);
+                for (int sx = x0; sx < x1; sx++) {
+                    Uint32 p = in[sx];
+                    Uint32 pa = p >> 24;
+                    a += pa;
+                    r += ((p >> 16) & 0xFF) * pa;
+                    g += ((p >> 8) & 0xFF) * pa;
+                    b += (p & 0xFF) * pa;
+                }
+            }
 
-    // read icon file into memory
-    void *buf = NULL;
-    size_t bufsize;
-    zip_entry_read(zip, &buf, &bufsize);
+            Uint32 count = (y1 - y0) * (x1 - x0);
+            if (a == 0) {out[dx] = 0; continue;}
+            out[dx] = ((Uint32)(a / count) << 24) | ((Uint32)(r / a) << 16) | ((Uint32)(g / a) << 8) | (Uint32)(b / a);
+        }
+    }
+
+    SDL_FreeSurface(src);
+    return dst;
+}
+
+// averages the icon down to the 4x4 placeholder kept in the app store
+bool icon_swatch(SDL_Surface* surface, Uint32* swatch) {
+    SDL_Surface *small = resize_icon(surface, SWATCH_SIZE);
+    if (small == NULL) {return false;}
 
-    // create SDL RWops so we can feed the data into a texture
-    SDL_RWops *icon_data = SDL_RWFromMem(buf, bufsize);
-    SDL_Texture *icon_tex, *new_icon_tex;
-    icon_tex = IMG_LoadTexture_RW(renderer, icon_data, 1);
+    for (int row = 0; row < SWATCH_SIZE; row++) {
+        memcpy(swatch + row * SWATCH_SIZE, (Uint8*)small->pixels + row * small->pitch, SWATCH_SIZE * sizeof(Uint32));
+    }
+    SDL_FreeSurface(small);
+    return true;
+}
 
-    // create another texture to resize the icon into
-    new_icon_tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, icon_size, icon_size);
+// an empty "<cache name>.none" file records that an IPA has no usable icon, so it
+// isn't unzipped again on every start. it's ignored once the IPA is newer than it
+std::string icon_fail_marker(const std::string& cache_name) {
+    return cache_name + ".none";
+}
 
-    SDL_SetRenderTarget(renderer, new_icon_tex);
-    SDL_SetTextureScaleMode(icon_tex, SDL_ScaleModeBest);
-    SDL_RenderCopy(renderer, icon_tex, NULL, NULL);
+void mark_icon_bad(const std::string& cache_name) {
+    FILE* marker = fopen(icon_fail_marker(cache_name).c_str(), "wb");
+    if (marker != NULL) {fclose(marker);}
+}
 
-    // render texture to a surface, then save it as a PNG file
-    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, icon_size, icon_size, 32, SDL_PIXELFORMAT_ARGB8888);
-    SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, surface->pixels, surface->pitch);
-    IMG_SavePNG(surface, name);
-    SDL_FreeSurface(surface);
+bool icon_known_bad(const std::string& file, const std::string& cache_name) {
+    std::error_code err;
+    auto marked = std::filesystem::last_write_time(icon_fail_marker(cache_name), err);
+    if (err) {return false;}
+    auto modified = std::filesystem::last_write_time(file, err);
+    return !err && marked >= modified;
+}
 
-    // clean up
-    SDL_SetRenderTarget(renderer, NULL);
-    SDL_DestroyTexture(icon_tex);
+// reads a whole zip entry into a malloc'd buffer, NULL if it isn't there
+void* read_zip_entry(struct zip_t* zip, const char* entry, size_t* size) {
+    void *buf = NULL;
+    *size = 0;
+    if (zip_entry_open(zip, entry) != 0) {return NULL;}
+    zip_entry_read(zip, &buf, size);
     zip_entry_close(zip);
+    return buf;
+}
+
+// width of a PNG from its header, without decoding it. 0 if it isn't a PNG
+int png_width(const Uint8* data, size_t size) {
+    static const Uint8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (size < 24 || memcmp(data, signature, 8) != 0) {return 0;}
+
+    // IHDR comes first, except in CgBI files where it's second
+    size_t pos = 8;
+    if (cgbi_is(data, size)) {pos += 12 + cgbi_be32(data + 8);}
+    if (pos + 16 > size || memcmp(data + pos + 4, "IHDR", 4) != 0) {return 0;}
+    return std::min<Uint32>(cgbi_be32(data + pos + 8), CGBI_MAX_SIDE);
+}
+
+// icon names from Info.plist: CFBundleIcons (iOS 5+, iPhone then iPad), then
+// CFBundleIconFiles (iOS 3.2+), then CFBundleIconFile (everything older)
+std::vector<std::string> plist_icon_names(const plist_value& info) {
+    std::vector<std::string> names;
+
+    auto add_files = [&](const plist_value* files) {
+        if (files == NULL) {return;}
+        if (files->kind == plist_value::STRING) {names.push_back(files->str);}
+        if (files->kind != plist_value::ARRAY) {return;}
+        for (auto& item: files->items) {
+            if (item.kind == plist_value::STRING) {names.push_back(item.str);}
+        }
+    };
+
+    for (const char* key: {"CFBundleIcons", "CFBundleIcons~ipad"}) {
+        const plist_value* icons = plist_get(info, key);
+        const plist_value* primary = icons ? plist_get(*icons, "CFBundlePrimaryIcon") : NULL;
+        if (primary) {add_files(plist_get(*primary, "CFBundleIconFiles"));}
+    }
+    add_files(plist_get(info, "CFBundleIconFiles"));
+    add_files(plist_get(info, "CFBundleIconFile"));
+
+    return names;
+}
+
+// does a file in the bundle belong to an icon name from the plist? names may leave off
+// ".png", and the files themselves carry @2x/@3x and ~ipad/~iphone variant suffixes
+bool icon_file_matches(std::string file, std::string icon) {
+    file = search_lower(file);
+    icon = search_lower(icon);
+    if (icon.size() > 4 && icon.compare(icon.size() - 4, 4, ".png") == 0) {icon.resize(icon.size() - 4);}
+
+    if (file.size() < icon.size() + 4 || file.compare(0, icon.size(), icon) != 0) {return false;}
+    if (file.compare(file.size() - 4, 4, ".png") != 0) {return false;}
+
+    std::string suffix = file.substr(icon.size(), file.size() - icon.size() - 4);
+    for (const char* variant: {"", "@2x", "@3x", "~ipad", "~iphone", "@2x~ipad", "@2x~iphone", "@3x~iphone"}) {
+        if (suffix == variant) {return true;}
+    }
+    return false;
+}
+
+// true for the app's own Info.plist, which sits directly in Payload/<name>.app/; nested
+// bundles and frameworks have Info.plists of their own further down
+bool is_app_info_plist(const std::string& entry) {
+    size_t slash = entry.find('/', 8);
+    return entry.compare(0, 8, "Payload/") == 0 && slash != std::string::npos && entry.compare(slash, std::string::npos, "/Info.plist") == 0;
+}
+
+// picks the icon to decode: of the icon files Info.plist lists, the smallest that's at
+// least icon_size wide, so we aren't decoding 512px artwork for a 96px slot. falls back
+// to iTunesArtwork when none are big enough, and to the biggest one when there's no artwork
+void* read_best_icon(struct zip_t* zip, int icon_size, size_t* size) {
+    std::vector<std::string> entries;
+    std::string info_plist;
+    int n = zip_entries_total(zip);
+
+    for (int i = 0; i < n; i++) {
+        zip_entry_openbyindex(zip, i);
+        std::string entry = zip_entry_name(zip);
+        zip_entry_close(zip);
+
+        if (is_app_info_plist(entry)) {info_plist = entry;}
+        entries.push_back(std::move(entry));
+    }
+
+    void *best = NULL;
+    size_t best_size = 0;
+    int best_width = 0;
+
+    size_t plist_size = 0;
+    void *plist = info_plist.empty() ? NULL : read_zip_entry(zip, info_plist.c_str(), &plist_size);
+    plist_value info;
+
+    if (plist != NULL && plist_parse((const char*)plist, plist_size, info)) {
+        std::string bundle = info_plist.substr(0, info_plist.size() - strlen("Info.plist"));
+        std::vector<std::string> names = plist_icon_names(info);
+
+        for (auto& entry: entries) {
+            if (entry.size() <= bundle.size() || entry.compare(0, bundle.size(), bundle) != 0) {continue;}
+            std::string file = entry.substr(bundle.size());
+            if (file.find('/') != std::string::npos) {continue;}
+
+            bool listed = false;
+            for (auto& name: names) {
+                if (icon_file_matches(file, name)) {listed = true; break;}
+            }
+            if (!listed) {continue;}
+
+            size_t candidate_size = 0;
+            void *candidate = read_zip_entry(zip, entry.c_str(), &candidate_size);
+            int width = candidate ? png_width((const Uint8*)candidate, candidate_size) : 0;
+
+            bool better = width >= icon_size ? (best_width < icon_size || width < best_width) : width > best_width;
+            if (width > 0 && better) {
+                free(best);
+                best = candidate;
+                best_size = candidate_size;
+                best_width = width;
+            } else {
+                free(candidate);
+            }
+        }
+    }
+    free(plist);
+
+    if (best_width < icon_size) {
+        size_t artwork_size = 0;
+        void *artwork = read_zip_entry(zip, "iTunesArtwork", &artwork_size);
+        if (artwork != NULL) {
+            free(best);
+            best = artwork;
+            best_size = artwork_size;
+        }
+    }
+
+    *size = best_size;
+    return best;
+}
+
+std::string icon_cache_file(const std::string& base, int level) {
+    return base + "." + std::to_string(level) + ".icon";
+}
+
+// drops what older versions cached for this app: <base>.png, then a PNG per level
+void remove_old_icon_cache(const std::string& base) {
+    std::error_code err;
+    std::filesystem::remove(base + ".png", err);
+    for (int level: icon_levels) {std::filesystem::remove(base + "." + std::to_string(level) + ".png", err);}
+}
+
+SDL_Surface* extract_icon(const char* file, const std::string& base, int level) {
+    // doesn't touch the renderer, so it's safe to call from worker threads
+    // writes the cache levels the source can fill, returns the one asked for. the source only
+    // has to cover what's needed at the current display scale, so the 57/114px icons old apps
+    // ship are used instead of decoding 512px artwork for every one of them
+    int icon_size = std::max(level, icon_level.load());
+    Uint64 t = SDL_GetPerformanceCounter();
+    struct zip_t *zip = zip_open(file, 0, 'r');
+    scan_stats.zip_open += SDL_GetPerformanceCounter() - t;
+
+    // a truncated or corrupt IPA won't open any better next time
+    if (zip == NULL) {
+        printf("[!] Couldn't open %s\n", file);
+        mark_icon_bad(base);
+        return NULL;
+    }
+
+    // read icon file into memory
+    t = SDL_GetPerformanceCounter();
+    size_t bufsize = 0;
+    void *buf = read_best_icon(zip, icon_size, &bufsize);
     zip_close(zip);
+
+    // most artwork is a normal PNG or JPEG, but Xcode-crushed PNGs need our own decoder
+    SDL_Surface *icon = NULL;
+    if (buf != NULL && cgbi_is((const Uint8*)buf, bufsize)) {
+        icon = cgbi_decode((const Uint8*)buf, bufsize);
+    } else if (buf != NULL) {
+        SDL_RWops *icon_data = SDL_RWFromMem(buf, bufsize);
+        icon = IMG_Load_RW(icon_data, 1);
+    }
+    free(buf);
+    scan_stats.decode += SDL_GetPerformanceCounter() - t;
+
+    if (icon == NULL) {
+        printf("[!] No usable icon in %s\n", file);
+        mark_icon_bad(base);
+        return NULL;
+    }
+
+    // the biggest level comes from the artwork, each smaller one from the level above it.
+    // levels bigger than both the source and what's needed now are left uncached, so a later
+    // switch to a denser display extracts them again from bigger art rather than upscaling
+    SDL_Surface *source = icon;
+    SDL_Surface *wanted = NULL;
+    int largest = std::max(icon->w, icon_size);
+
+    for (int l = ICON_LEVEL_COUNT - 1; l >= 0; l--) {
+        if (icon_levels[l] > largest) {continue;}
+
+        t = SDL_GetPerformanceCounter();
+        SDL_Surface *mip = resize_icon(source, icon_levels[l]);
+        if (source != wanted) {SDL_FreeSurface(source);}
+        scan_stats.icon_resize += SDL_GetPerformanceCounter() - t;
+
+        source = mip;
+        if (mip == NULL) {break;}
+
+        // only the encoding happens here, the writer thread does the disk I/O
+        t = SDL_GetPerformanceCounter();
+        std::vector<Uint8> data;
+        if (icon_cache_encode(mip, icon_encoding, data)) {
+            writer_push(icon_writer, icon_cache_file(base, icon_levels[l]), std::move(data));
+        }
+        scan_stats.cache_write += SDL_GetPerformanceCounter() - t;
+
+        if (icon_levels[l] == level) {wanted = mip;}
+    }
+
+    if (source != wanted) {SDL_FreeSurface(source);}
+    remove_old_icon_cache(base);
+    return wanted;
 }
 
 app extract_plist_metadata(const char* file) {
     app output;
+    Uint64 t = SDL_GetPerformanceCounter();
     struct zip_t *zip = zip_open(file, 0, 'r');
-    std::string info_plist_path = "dummy";
+    scan_stats.zip_open += SDL_GetPerformanceCounter() - t;
+    if (zip == NULL) {return output;}
+    std::string info_plist_path;
 
     // the path to get a given IPA's info.plist is NOT trivial or predictable
     // so the best way to find it, unfortunately, is to just loop over the
-    // entire file until we find the Info.plist file
+    // entire file until we find the app's own Info.plist file
+    t = SDL_GetPerformanceCounter();
     int n = zip_entries_total(zip);
 
     for (int i = 0; i < n; i++) {
         zip_entry_openbyindex(zip, i);
         std::string name = zip_entry_name(zip);
+        zip_entry_close(zip);
 
-        if (name.find("Info.plist") != std::string::npos) {
+        if (is_app_info_plist(name)) {
             info_plist_path = name;
-            zip_entry_close(zip);
             break;
         }
+    }
 
+    // read contents of plist into buffer that we can do stuff with
+    void *buf = NULL;
+    size_t bufsize = 0;
+    if (!info_plist_path.empty() && zip_entry_open(zip, info_plist_path.c_str()) == 0) {
+        zip_entry_read(zip, &buf, &bufsize);
         zip_entry_close(zip);
     }
+    scan_stats.plist_locate += SDL_GetPerformanceCounter() - t;
 
-    zip_entry_open(zip, info_plist_path.c_str());
+    zip_close(zip);
 
-    // read contents of plist into buffer that we can do stuff with
-    void *buf = NULL;
-    size_t bufsize;
-    zip_entry_read(zip, &buf, &bufsize);
+    // Info.plist can be either XML or binary, plist.h handles both
+    plist_value info;
+    if (plist_parse((const char*)buf, bufsize, info)) {
+        std::string name = plist_get_string(info, "CFBundleDisplayName");
+        if (name.empty()) {name = plist_get_string(info, "CFBundleName");}
+        if (!name.empty()) {output.name = name;}
 
-    // TODO: parse the plist here. Probably need to find a library to read Plist binary because I REALLY don't want to write my own. (Apple's code is open-source but I'm unsure of its licensing and it looks to use a lot of extra libs :<)
+        std::string version = plist_get_string(info, "MinimumOSVersion");
+        if (!version.empty()) {output.version = version;}
 
-    zip_entry_close(zip);
-    zip_close(zip);
+        output.bundle_id = plist_get_string(info, "CFBundleIdentifier");
+    }
+    free(buf);
 
     return output;
 }
 
 void display_background() {
     // just for fun :)
+    prof_scope scope(PROF_BACKGROUND);
+    // filled rather than cleared, since SDL_RenderClear ignores the clip rect partial redraws use
     SDL_SetRenderDrawColor(renderer, 8, 0, 16, 255);
-    SDL_RenderClear(renderer);
+    SDL_RenderFillRect(renderer, NULL);
 
     SDL_Rect box;
-    float time = SDL_GetTicks() * 0.001;
+    float time = animate_background ? SDL_GetTicks() * 0.001 : 0;
 
     SDL_SetRenderDrawColor(renderer, 255, 128, 64, 32);
     for (int i = 0; i < width; i++) {
@@ -251,45 +693,191 @@ void display_background() {
 
         SDL_RenderFillRect(renderer, &box);
     }
+    profiler.draw_calls += width + 1;
+}
+
+void draw_swatch(const Uint32* swatch, SDL_Rect box) {
+    // the icon's 4x4 preview, one flat rectangle per cell
+    for (int cy = 0; cy < SWATCH_SIZE; cy++) {
+        for (int cx = 0; cx < SWATCH_SIZE; cx++) {
+            SDL_Rect cell;
+            cell.x = box.x + cx * box.w / SWATCH_SIZE;
+            cell.y = box.y + cy * box.h / SWATCH_SIZE;
+            cell.w = box.x + (cx + 1) * box.w / SWATCH_SIZE - cell.x;
+            cell.h = box.y + (cy + 1) * box.h / SWATCH_SIZE - cell.y;
+
+            Uint32 c = swatch[cy * SWATCH_SIZE + cx];
+            SDL_SetRenderDrawColor(renderer, (c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF, c >> 24);
+            SDL_RenderFillRect(renderer, &cell);
+            profiler.draw_calls++;
+        }
+    }
+}
+
+float list_scroll_y() {
+    // the scroll position, snapped to a real pixel so rows don't shimmer as they move
+    return roundf(list_scroll.pos * display_scale) / display_scale;
+}
+
+void update_layout() {
+    layout_update(app_layout, width, height - 24, visible_count);
+}
+
+float list_scroll_max() {
+    // far enough to bring the last row up above the options bar
+    update_layout();
+    return layout_content_height(app_layout) - app_layout.view_h;
+}
+
+int list_index_at(int x, int y) {
+    // the visible_apps position under window x, y, or -1
+    return layout_hit(app_layout, x, y, list_scroll_y());
+}
+
+void list_visible(int& first, int& last) {
+    // the visible_apps positions at least partly on screen, last exclusive
+    layout_visible(app_layout, list_scroll_y(), height, first, last);
+}
+
+SDL_Rect enclosing_rect(const SDL_FRect& box) {
+    int x0 = floor(box.x), y0 = floor(box.y);
+    return {x0, y0, (int)ceil(box.x + box.w) - x0, (int)ceil(box.y + box.h) - y0};
+}
+
+void draw_app_icon(int i, SDL_Rect icon) {
+    if (apps_list.flags[i] & APP_HAS_ICON) {
+        SDL_RenderCopy(renderer, apps_list.icon[i], NULL, &icon);
+        profiler.draw_calls++;
+    } else if (apps_list.flags[i] & APP_HAS_SWATCH) {
+        draw_swatch(&apps_list.swatch[i * SWATCH_CELLS], icon);
+    } else {
+        // placeholder icon
+        SDL_SetRenderDrawColor(renderer, i*16, i*32, i*64, 255);
+        SDL_RenderFillRect(renderer, &icon);
+        draw_text(std::to_string(i), icon.x, icon.y);
+        profiler.draw_calls++;
+    }
+}
+
+void draw_row(int i, int app_y_pos) {
+    // one app's icon, filename and play stats, with its top edge at app_y_pos
+    SDL_Rect icon;
+    icon.w = icon.h = ICON_DRAW_SIZE;
+    icon.x = 2;
+    SDL_Color version_col = {255, 96, 96};
+
+    //draw_text(store_str(apps_list, apps_list.name[i]), 64, app_y_pos);
+    draw_text(store_str(apps_list, apps_list.filename[i]), 64, app_y_pos + 16); // , 1, 1, width, {127, 127, 160}
+    //draw_text("iOS version " + string(store_str(apps_list, apps_list.version[i])), 64, app_y_pos + 32, 1, 1, width, version_col);
+
+    // play stats, with a warning for apps touchHLE keeps bailing out of
+    if (apps_list.play_count[i] > 0) {
+        int minutes = apps_list.playtime[i] / 60;
+        string stats = "played " + std::to_string(apps_list.play_count[i]) + "x, " + std::to_string(minutes / 60) + "h " + std::to_string(minutes % 60) + "m";
+        float stats_width = draw_text(stats, 64, app_y_pos + 34, 1, 1, width - 64, {127, 127, 160});
+
+        if (apps_list.flags[i] & APP_QUICK_EXIT) {
+            int warning_x = 64 + (int)ceilf(stats_width) + 2 * font_atlas.char_w;
+            draw_text("exited immediately last time", warning_x, app_y_pos + 34, 1, 1, width - warning_x, {255, 96, 96});
+        }
+    }
+
+    icon.y = app_y_pos;
+    draw_app_icon(i, icon);
+}
+
+void draw_tile(int i, SDL_Rect cell) {
+    // grid view: the icon with the filename centred underneath, cut short rather than squashed
+    // to fit; apps touchHLE keeps bailing out of get a red name
+    SDL_Rect icon;
+    icon.w = icon.h = ICON_DRAW_SIZE;
+    icon.x = cell.x + (cell.w - ICON_DRAW_SIZE) / 2;
+    icon.y = cell.y + 6;
+    draw_app_icon(i, icon);
+
+    if (font_atlas.texture == NULL) {return;}
+    string name = store_str(apps_list, apps_list.filename[i]);
+    int fits = std::max(3, (cell.w - 8) / font_atlas.char_w);
+    if (text_columns(name) > fits) {name = name.substr(0, utf8_fit(name, fits - 2)) + "..";}
+
+    SDL_Color col = (apps_list.flags[i] & APP_QUICK_EXIT) ? SDL_Color{255, 96, 96} : SDL_Color{255, 255, 255};
+    draw_text(name, cell.x + cell.w / 2, icon.y + ICON_DRAW_SIZE + 6, 1, 0, cell.w - 8, col);
+}
+
+void draw_cell(int i, SDL_Rect cell) {
+    if (app_layout.mode == LAYOUT_GRID) {draw_tile(i, cell);}
+    else {draw_row(i, cell.y + 2);}
+}
+
+Uint64 row_signature(int i) {
+    // everything draw_row() reads for app i; the strip is redrawn whenever this changes
+    Uint64 hash = ROW_HASH_SEED;
+    hash = row_hash(hash, &apps_list.filename[i], sizeof(apps_list.filename[i]));
+    hash = row_hash(hash, &apps_list.flags[i], sizeof(apps_list.flags[i]));
+    hash = row_hash(hash, &apps_list.play_count[i], sizeof(apps_list.play_count[i]));
+    hash = row_hash(hash, &apps_list.playtime[i], sizeof(apps_list.playtime[i]));
+    hash = row_hash(hash, &apps_list.icon[i], sizeof(apps_list.icon[i]));
+    Uint32 glyphs = atlas_epoch(font_atlas);
+    hash = row_hash(hash, &glyphs, sizeof(glyphs));
+    return row_hash(hash, &apps_list.swatch[i * SWATCH_CELLS], SWATCH_CELLS * sizeof(Uint32));
+}
+
+bool hover_underlay(SDL_FRect& box) {
+    // the highlight behind the app under the mouse, if there is one
+    int index = list_index_at(x, y);
+    if (index < 0) {return false;}
+    box = layout_cell(app_layout, index, list_scroll_y());
+    return true;
 }
 
 void display_list() {
+    prof_scope scope(PROF_LIST);
+    update_layout();
+
     if (apps_count <= 0) {
         draw_text("Could not find any apps. =(", width/2, height/2, 1, 0);
+    } else if (visible_count <= 0) {
+        draw_text("No apps match \"" + search_query + "\"", width/2, height/2, 1, 0);
     } else {
-        SDL_Rect icon;
-        icon.w = icon.h = 57;
-        icon.x = 2;
-
         // draws underlay
-        if (y < (apps_count*64) + (scroll_offset*64) && y < height - 24) {
-            SDL_Rect app_box;
-            app_box.x = 0;
-            app_box.y = (y/64) * 64;
-            app_box.w = width;
-            app_box.h = 64;
-
+        SDL_FRect app_box;
+        if (hover_underlay(app_box)) {
             SDL_SetRenderDrawColor(renderer, 64, 0, 96, 128);
-            SDL_RenderFillRect(renderer, &app_box);
+            SDL_RenderFillRectF(renderer, &app_box);
+            profiler.draw_calls++;
         }
 
-        for (int i = 0; i < apps_count; i++) {
-            SDL_Color version_col = {255, 96, 96};
-
-            int app_y_pos = (scroll_offset*64) + (i*64) + 2;
-
-            //draw_text(apps_list[i].name, 64, app_y_pos);
-            draw_text(apps_list[i].filename, 64, app_y_pos + 16); // , 1, 1, width, {127, 127, 160}
-            //draw_text("iOS version " + apps_list[i].version, 64, app_y_pos + 32, 1, 1, width, version_col);
+        // only cells on screen are drawn; strips are in real pixels so HiDPI text stays sharp
+        int first, last;
+        list_visible(first, last);
+        float top = list_scroll_y();
+        row_cache_begin(list_rows, ceil(app_layout.cell_w * display_scale), ceil(app_layout.cell_h * display_scale),
+                        last - first + ROW_CACHE_SPARE * app_layout.columns);
+        SDL_Texture* screen = SDL_GetRenderTarget(renderer);
+
+        for (int index = first; index < last; index++) {
+            int i = visible_apps[index];
+            SDL_FRect cell = layout_cell(app_layout, index, top);
+
+            bool redraw = false;
+            SDL_Texture* strip = row_cache_get(list_rows, renderer, i, row_signature(i), redraw);
+            if (strip == NULL) {
+                draw_cell(i, enclosing_rect(cell));
+                continue;
+            }
 
-            icon.y = app_y_pos;
+            if (redraw) {
+                // setting a target resets the renderer's scale, so put the display's back
+                SDL_SetRenderTarget(renderer, strip);
+                SDL_RenderSetScale(renderer, display_scale, display_scale);
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+                SDL_RenderClear(renderer);
+                draw_cell(i, {0, 0, app_layout.cell_w, app_layout.cell_h});
+                SDL_SetRenderTarget(renderer, screen);
+            }
 
-            // placeholder icon
-            SDL_SetRenderDrawColor(renderer, i*16, i*32, i*64, 255);
-            SDL_RenderFillRect(renderer, &icon);
-            draw_text(std::to_string(i), 2, icon.y);
-            SDL_SetTextureScaleMode(apps_list[i].icon, SDL_ScaleModeLinear);
-            SDL_RenderCopy(renderer, apps_list[i].icon, NULL, &icon);
+            SDL_RenderCopyF(renderer, strip, NULL, &cell);
+            profiler.draw_calls++;
         }
     }
 }
@@ -310,86 +898,947 @@ void display_options_bar() {
     SDL_SetRenderDrawColor(renderer, 64, 0, 96, 255);
     SDL_RenderFillRect(renderer, &button);
 
+    profiler.draw_calls += 2;
+
     if (toggle_pause) {
         SDL_SetRenderDrawColor(renderer, 255, 128, 64, 255);
         SDL_RenderFillRect(renderer, &button);
+        profiler.draw_calls++;
     }
 
     draw_text("pause console on exit", 28, height - 24);
 
+    // search box, typing anywhere edits it
+    if (search_query.empty()) {
+        string sort_label = string("sort: ") + sort_mode_names[current_sort] + (group_by_folder ? " by folder" : "");
+        draw_text(sort_label, 300, height - 24, 1, 1, width - 480, {127, 127, 160});
+    } else {
+        string mode = fuzzy_search ? "fuzzy: " : "exact: ";
+        draw_text(mode + search_query + "_", 300, height - 24, 1, 1, width - 480, {255, 255, 96});
+    }
+
     draw_text("shannon v1.0.3", width - 2, height - 24, 1, -1);
 }
 
-void scan_apps() {
-    if (!std::filesystem::is_directory(apps)) {
-        printf("[!] The apps directory (%s) couldn't be found!\n", apps.string().c_str());
+void display_profiler() {
+    // frame-time histogram plus the previous frame's per-zone breakdown
+    SDL_Rect panel, bar;
+    panel.w = PROF_HISTORY + 8;
+    panel.h = 96 + (PROF_ZONE_COUNT + 4) * 18;
+    panel.x = width - panel.w - 4;
+    panel.y = 4;
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 192);
+    SDL_RenderFillRect(renderer, &panel);
+
+    // each bar is one frame, scaled so 33ms fills the 80px graph
+    float total_ms = 0, worst_ms = 0;
+    bar.w = 1;
+    for (int i = 0; i < PROF_HISTORY; i++) {
+        float ms = profiler.frame_ms[(profiler.frame_index + i) % PROF_HISTORY];
+        total_ms += ms;
+        worst_ms = fmax(worst_ms, ms);
+
+        bar.h = fmin(80, ms * (80 / 33.3f));
+        bar.x = panel.x + 4 + i;
+        bar.y = panel.y + 84 - bar.h;
+
+        if (ms > 33.4f)      {SDL_SetRenderDrawColor(renderer, 255, 64, 64, 255);}
+        else if (ms > 16.7f) {SDL_SetRenderDrawColor(renderer, 255, 192, 64, 255);}
+        else                 {SDL_SetRenderDrawColor(renderer, 96, 255, 96, 255);}
+        SDL_RenderFillRect(renderer, &bar);
+    }
+
+    // 60fps budget line
+    bar.x = panel.x + 4;
+    bar.y = panel.y + 84 - (int)(16.7f * (80 / 33.3f));
+    bar.w = PROF_HISTORY;
+    bar.h = 1;
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 96);
+    SDL_RenderFillRect(renderer, &bar);
+
+    SDL_Color col = {255, 255, 96};
+    int line_y = panel.y + 92;
+    char line[64];
+
+    snprintf(line, sizeof(line), "avg %.2fms  max %.2fms", total_ms / PROF_HISTORY, worst_ms);
+    draw_text(line, panel.x + 4, line_y, 1, 1, panel.w - 8, col);
+    line_y += 18;
+
+    for (int i = 0; i < PROF_ZONE_COUNT; i++) {
+        snprintf(line, sizeof(line), "%s %.3fms", prof_zone_names[i], prof_ms(profiler.last_zone_ticks[i]));
+        draw_text(line, panel.x + 4, line_y, 1, 1, panel.w - 8, col);
+        line_y += 18;
+    }
+
+    // font texture, cached row strips and every loaded icon
+    int textures = 1 + list_rows.strips.size();
+    for (int i = 0; i < apps_count; i++) {
+        if (apps_list.flags[i] & APP_HAS_ICON) {textures++;}
+    }
+
+    snprintf(line, sizeof(line), "draw calls %d  textures %d", profiler.last_draw_calls, textures);
+    draw_text(line, panel.x + 4, line_y, 1, 1, panel.w - 8, col);
+    line_y += 18;
+
+    snprintf(line, sizeof(line), "mouse %d, %d", x, y);
+    draw_text(line, panel.x + 4, line_y, 1, 1, panel.w - 8, col);
+    line_y += 18;
+
+    draw_text(profiler.tracing ? "F4: stop trace (recording)" : "F4: start trace", panel.x + 4, line_y, 1, 1, panel.w - 8, col);
+}
+
+// what was on screen last frame, compared against the next one to find what to redraw
+struct drawn_frame {
+    int width = 0, height = 0;
+    float scale = 0;
+    float scroll = 0;
+    int mode = LAYOUT_LIST;
+    int first = 0;
+    std::vector<Uint64> cells;  // one per app on screen, from visible_apps[first]
+    SDL_FRect underlay = {0, 0, 0, 0};
+    Uint64 options_bar = 0;
+    Uint64 message = 0;         // "no apps"/"no matches" text, 0 when the list is shown
+    bool overlay = false;
+    Uint32 glyphs = 0;          // atlas_epoch(), which changes if text may have been drawn with glyphs missing
+};
+
+drawn_frame last_drawn;
+
+void find_changes() {
+    // adds everything that's going to look different from last frame to frame_dirty
+    drawn_frame now;
+    now.width = width;
+    now.height = height;
+    now.scale = display_scale;
+    now.overlay = profiler.overlay;
+    now.scroll = list_scroll_y();
+    now.mode = app_layout.mode;
+    now.glyphs = atlas_epoch(font_atlas);
+
+    int last;
+    update_layout();
+    list_visible(now.first, last);
+    for (int index = now.first; index < last; index++) {
+        int i = visible_apps[index];
+        now.cells.push_back(row_hash(row_signature(i), &i, sizeof(i)));
+    }
+
+    if (apps_count <= 0 || visible_count <= 0) {
+        now.message = row_hash(row_hash(ROW_HASH_SEED, &apps_count, sizeof(apps_count)), search_query.data(), search_query.size());
+    }
+
+    hover_underlay(now.underlay);
+
+    Uint64 bar = ROW_HASH_SEED;
+    for (int value: {(int)toggle_pause, current_sort, (int)group_by_folder, (int)fuzzy_search}) {bar = row_hash(bar, &value, sizeof(value));}
+    now.options_bar = row_hash(bar, search_query.data(), search_query.size());
+
+    // anything covering the whole window, a change of window size or scrolling means redrawing all of it
+    if (animate_background || now.overlay || last_drawn.overlay || now.width != last_drawn.width ||
+        now.height != last_drawn.height || now.scale != last_drawn.scale || now.message != last_drawn.message ||
+        now.scroll != last_drawn.scroll || now.mode != last_drawn.mode || now.glyphs != last_drawn.glyphs) {
+        dirty_all(frame_dirty);
+    } else {
+        // cells the list grew or shrank by count as changed too
+        size_t cells = std::max(now.cells.size(), last_drawn.cells.size());
+        for (size_t slot = 0; slot < cells; slot++) {
+            Uint64 before = slot < last_drawn.cells.size() ? last_drawn.cells[slot] : 0;
+            Uint64 after = slot < now.cells.size() ? now.cells[slot] : 0;
+            SDL_FRect box = layout_cell(app_layout, now.first + slot, now.scroll);
+            if (before != after) {dirty_add(frame_dirty, enclosing_rect(box));}
+        }
+
+        if (memcmp(&now.underlay, &last_drawn.underlay, sizeof(SDL_FRect)) != 0) {
+            dirty_add(frame_dirty, enclosing_rect(last_drawn.underlay));
+            dirty_add(frame_dirty, enclosing_rect(now.underlay));
+        }
+
+        if (now.options_bar != last_drawn.options_bar) {dirty_add(frame_dirty, {0, height - 24, width, 24});}
+    }
+
+    last_drawn = now;
+}
+
+void display_frame() {
+    if (!partial_redraw) {
+        display_background();
+        display_list();
+        display_options_bar();
+        if (profiler.overlay) {display_profiler();}
+
+        prof_scope scope(PROF_PRESENT);
+        SDL_RenderPresent(renderer);
+        return;
+    }
+
+    find_changes();
+    if (dirty_empty(frame_dirty)) {
+        // nothing to draw, so wait for input rather than spinning; the timeout keeps the
+        // watchers and icon loading ticking over
+        SDL_WaitEventTimeout(NULL, IDLE_WAIT_MS);
         return;
     }
 
+    std::vector<SDL_Rect> rects = dirty_rects(frame_dirty, width, height);
+    for (SDL_Rect& rect: rects) {
+        SDL_RenderSetClipRect(renderer, &rect);
+        display_background();
+        display_list();
+        display_options_bar();
+    }
+    SDL_RenderSetClipRect(renderer, NULL);
+
+    // the overlay always makes the frame a full one
+    if (profiler.overlay) {display_profiler();}
+
+    prof_scope scope(PROF_PRESENT);
+
+    // the software renderer draws straight into the window surface, so presenting is just
+    // copying the changed parts of that to the screen, in real pixels
+    SDL_RenderFlush(renderer);
+    for (SDL_Rect& rect: rects) {
+        int x0 = floor(rect.x * display_scale), y0 = floor(rect.y * display_scale);
+        int x1 = ceil((rect.x + rect.w) * display_scale), y1 = ceil((rect.y + rect.h) * display_scale);
+        rect = {x0, y0, x1 - x0, y1 - y0};
+    }
+    SDL_UpdateWindowSurfaceRects(window, rects.data(), rects.size());
+    dirty_reset(frame_dirty);
+}
+
+void filter_apps() {
+    // re-runs the current search query and keeps the scroll position in range
+    // fuzzy results stay in score order, everything else follows the current sort
+    if (search_query.empty()) {
+        visible_apps = sort_orders[current_sort];
+    } else if (fuzzy_search) {
+        fuzzy_run(apps_fuzzy, apps_list, search_query, visible_apps);
+    } else {
+        std::vector<int> matches;
+        std::vector<char> matched(apps_count, 0);
+        search_run(apps_search, apps_list, search_query, matches);
+        for (int i: matches) {matched[i] = 1;}
+
+        visible_apps.clear();
+        for (int i: sort_orders[current_sort]) {
+            if (matched[i]) {visible_apps.push_back(i);}
+        }
+    }
+    visible_count = visible_apps.size();
+    scroll_set_range(list_scroll, list_scroll_max());
+}
+
+bool sort_before(int mode, int a, int b) {
+    // true if app a goes above app b; ties fall through to name, then filename, so orders are stable
+    const app_store& store = apps_list;
+    switch (mode) {
+        case SORT_SIZE:        if (store.size[a] != store.size[b]) {return store.size[a] > store.size[b];} break;
+        case SORT_ADDED:       if (store.added[a] != store.added[b]) {return store.added[a] > store.added[b];} break;
+        case SORT_LAST_PLAYED: if (store.last_played[a] != store.last_played[b]) {return store.last_played[a] > store.last_played[b];} break;
+        case SORT_PLAY_COUNT:  if (store.play_count[a] != store.play_count[b]) {return store.play_count[a] > store.play_count[b];} break;
+    }
+
+    if (store.name[a] != store.name[b]) {
+        int by_name = SDL_strcasecmp(store_str(store, store.name[a]), store_str(store, store.name[b]));
+        if (by_name != 0) {return by_name < 0;}
+    }
+
+    int by_file = strcmp(store_str(store, store.filename[a]), store_str(store, store.filename[b]));
+    if (by_file != 0) {return by_file < 0;}
+    return a < b;
+}
+
+bool order_before(int mode, int a, int b) {
+    Uint32 folder_a = apps_list.folder[a], folder_b = apps_list.folder[b];
+    if (group_by_folder && folder_a != folder_b) {
+        return strcmp(store_str(apps_list, folder_a), store_str(apps_list, folder_b)) < 0;
+    }
+    return sort_before(mode, a, b);
+}
+
+void rebuild_sort_orders() {
+    // sorts indices only, apps_list itself never moves
+    for (int mode = 0; mode < SORT_MODE_COUNT; mode++) {
+        std::vector<int>& order = sort_orders[mode];
+        order.resize(apps_count);
+        for (int i = 0; i < apps_count; i++) {order[i] = i;}
+        std::sort(order.begin(), order.end(), [&](int a, int b) {return order_before(mode, a, b);});
+    }
+}
+
+void rebuild_indices() {
+    // after the whole of apps_list changes; single apps go through list_add() and friends
+    rebuild_sort_orders();
+    search_build(apps_search, apps_list);
+    fuzzy_build(apps_fuzzy, apps_list);
+    filter_apps();
+}
+
+// puts app i into the sort orders where it belongs
+void orders_insert(int i) {
+    for (int mode = 0; mode < SORT_MODE_COUNT; mode++) {
+        std::vector<int>& order = sort_orders[mode];
+        auto pos = std::lower_bound(order.begin(), order.end(), i, [&](int a, int b) {return order_before(mode, a, b);});
+        order.insert(pos, i);
+    }
+}
+
+void orders_erase(int i) {
+    for (auto& order: sort_orders) {order.erase(std::find(order.begin(), order.end(), i));}
+}
+
+// apps_list changes made while running go through these, which keep the search indices and sort
+// orders up to date one app at a time rather than rebuilding them; filter_apps() afterwards
+int list_add(const app& entry) {
+    int i = store_add(apps_list, entry);
+    apps_count = apps_list.count;
+    search_add(apps_search, apps_list, i);
+    fuzzy_update(apps_fuzzy, apps_list, i);
+    orders_insert(i);
+    return i;
+}
+
+void list_set(int i, const app& entry) {
+    search_remove(apps_search, apps_list, i);
+    orders_erase(i);
+    store_set(apps_list, i, entry);
+    search_add(apps_search, apps_list, i);
+    fuzzy_update(apps_fuzzy, apps_list, i);
+    orders_insert(i);
+}
+
+// like store_remove(), the last app moves into slot i
+void list_remove(int i) {
+    int last = apps_list.count - 1;
+    search_remove(apps_search, apps_list, i);
+    orders_erase(i);
+    if (i != last) {
+        search_remove(apps_search, apps_list, last);
+        orders_erase(last);
+    }
+
+    store_remove(apps_list, i);
+    apps_count = apps_list.count;
+    fuzzy_remove(apps_fuzzy, i);
+    if (i != last) {
+        search_add(apps_search, apps_list, i);
+        orders_insert(i);
+    }
+}
+
+std::string icon_cache_base(const app& entry) {
+    // cache file names minus the level and extension
+    // IPAs directly inside touchHLE_apps keep plain filename cache names; anything nested or
+    // in another root gets a hash of its full path appended so same-named IPAs don't collide
+    if (std::filesystem::path(entry.filepath).parent_path() == apps) {
+        return icon_cache.string() + "/" + entry.filename;
+    }
+
+    Uint32 hash = 2166136261u;
+    for (char c: entry.filepath) {hash = (hash ^ (Uint8)c) * 16777619u;}
+
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%08x", hash);
+    return icon_cache.string() + "/" + entry.filename + suffix;
+}
+
+SDL_Surface* load_cached_icon(const std::string& path) {
+    // files the writer hasn't got to yet are read straight from its queue
+    std::vector<Uint8> data;
+    if (writer_pending(icon_writer, path, data)) {return icon_cache_decode(data.data(), data.size());}
+    return icon_cache_load(path.c_str());
+}
+
+void remove_icon_cache(const std::string& base) {
+    // queued writes of these files are dropped, or they'd recreate them afterwards
+    std::error_code err;
+    for (int level: icon_levels) {
+        writer_forget(icon_writer, icon_cache_file(base, level));
+        std::filesystem::remove(icon_cache_file(base, level), err);
+    }
+    std::filesystem::remove(icon_fail_marker(base), err);
+    remove_old_icon_cache(base);
+}
+
+void rename_icon_cache(const std::string& old_base, const std::string& new_base) {
+    std::error_code err;
+    for (int level: icon_levels) {
+        writer_move(icon_writer, icon_cache_file(old_base, level), icon_cache_file(new_base, level));
+        std::filesystem::rename(icon_cache_file(old_base, level), icon_cache_file(new_base, level), err);
+    }
+    std::filesystem::rename(icon_fail_marker(old_base), icon_fail_marker(new_base), err);
+}
+
+SDL_Surface* load_icon_surface(const app& entry, int level) {
+    // worker-safe; loads the cached icon, extracting it from the IPA first if it isn't cached yet
+    std::string base = icon_cache_base(entry);
+    std::string cache_path = icon_cache_file(base, level);
+
+    Uint64 t = SDL_GetPerformanceCounter();
+    SDL_Surface* surface = load_cached_icon(cache_path);
+    scan_stats.cache_load += SDL_GetPerformanceCounter() - t;
+
+    if (surface == NULL && !icon_known_bad(entry.filepath, base)) {
+        surface = extract_icon(entry.filepath.c_str(), base, level);
+    }
+
+    return surface;
+}
+
+SDL_Texture* icon_texture(SDL_Surface* surface) {
+    // render thread only; takes ownership of the surface
+    if (surface == NULL) {return NULL;}
+    SDL_Texture* icon = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_SetTextureScaleMode(icon, SDL_ScaleModeLinear);
+    SDL_FreeSurface(surface);
+    return icon;
+}
+
+void load_icon_swatch(app& entry) {
+    // worker-safe; reads the smallest cache level, extracting the icon first if it isn't cached
+    std::string base = icon_cache_base(entry);
+
+    Uint64 t = SDL_GetPerformanceCounter();
+    SDL_Surface* surface = load_cached_icon(icon_cache_file(base, icon_levels[0]));
+    scan_stats.cache_load += SDL_GetPerformanceCounter() - t;
+
+    if (surface == NULL && !icon_known_bad(entry.filepath, base)) {
+        surface = extract_icon(entry.filepath.c_str(), base, icon_levels[0]);
+    }
+
+    entry.has_swatch = surface != NULL && icon_swatch(surface, entry.swatch);
+    SDL_FreeSurface(surface);
+}
+
+void app_history(app& app_entry) {
+    auto played = history.apps.find(app_entry.filepath);
+    if (played != history.apps.end()) {
+        app_entry.play_count = played->second.count;
+        app_entry.playtime = played->second.total_seconds;
+        app_entry.last_played = played->second.last_played;
+        app_entry.quick_exit = played->second.last_quick;
+    }
+}
+
+app make_app_entry(const std::filesystem::path& path, bool with_history = true) {
+    // everything except the icon texture, safe to call from worker threads. history is only
+    // written on the render thread, so reads that can overlap a launch leave it to app_history()
+    app app_entry = extract_plist_metadata(path.string().c_str());
+    app_entry.filename = path.filename().string();
+    app_entry.filepath = path.string();
+    app_entry.icon = NULL;
+
+    std::error_code err;
+    app_entry.size = std::filesystem::file_size(path, err);
+    auto mtime = std::filesystem::last_write_time(path, err);
+    app_entry.added = std::chrono::duration_cast<std::chrono::seconds>(mtime.time_since_epoch()).count();
+
+    // the initial scan finishes before anything can be launched
+    if (with_history) {app_history(app_entry);}
+    return app_entry;
+}
+
+app make_app(const std::filesystem::path& path, bool with_history = true) {
+    // the icon texture itself is left to load_visible_icons()
+    app app_entry = make_app_entry(path, with_history);
+    load_icon_swatch(app_entry);
+    return app_entry;
+}
+
+void load_app_roots(int argc, char* args[]) {
+    // --apps <dir> may be given more than once; otherwise shannon_dirs.txt lists one directory per line
+    for (int i = 1; i < argc; i++) {
+        if (string(args[i]) == "--apps" && i + 1 < argc) {
+            app_roots.push_back(args[++i]);
+        }
+    }
+
+    if (app_roots.empty()) {
+        std::ifstream file(roots_file);
+        std::string line;
+
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') {line.pop_back();}
+            if (line.empty() || line[0] == '#') {continue;}
+            app_roots.push_back(line);
+        }
+    }
+
+    if (app_roots.empty()) {app_roots.push_back(apps);}
+}
+
+struct scan_state {
+    task_pool pool;
+    std::mutex lock;
+    std::condition_variable ready;
+    std::vector<app> done;
+    std::map<std::string, file_stamp> files;    // every IPA listed, by path, to seed the watchers with
+};
+
+void scan_directory(scan_state& scan, std::filesystem::path dir) {
+    // directories are listed in parallel; every subdirectory becomes its own task and every
+    // IPA goes straight to the extraction queue, so extraction starts before the listing ends
+    std::error_code err;
+
+    for (auto& entry: std::filesystem::directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, err)) {
+        if (entry.is_directory(err) && !entry.is_symlink(err)) {
+            std::filesystem::path subdir = entry.path();
+            pool_push(scan.pool, [&scan, subdir] {scan_directory(scan, subdir);}, true);
+        } else if (entry.path().extension() == ".ipa") {
+            // stamped before it's read, so a change made while it's being read still shows up as one
+            file_stamp stamp;
+            stamp.size = entry.file_size(err);
+            stamp.mtime = entry.last_write_time(err);
+            {
+                std::lock_guard<std::mutex> guard(scan.lock);
+                scan.files[entry.path().string()] = stamp;
+            }
+
+            std::filesystem::path ipa = entry.path();
+            pool_push(scan.pool, [&scan, ipa] {
+                app result = make_app(ipa);
+
+                std::lock_guard<std::mutex> guard(scan.lock);
+                scan.done.push_back(result);
+                scan.ready.notify_one();
+            });
+        }
+    }
+}
+
+// gives the polling watchers their first snapshot, from a listing of every root keyed by path
+void seed_watchers(const std::map<std::string, file_stamp>& files) {
+    for (auto& watcher: apps_watchers) {
+        std::map<std::string, file_stamp> known;
+        for (auto& file: files) {
+            std::filesystem::path relative = std::filesystem::path(file.first).lexically_relative(watcher.dir);
+            if (relative.empty() || *relative.begin() == "..") {continue;}
+            known[relative.generic_string()] = file.second;
+        }
+        watcher_seed(watcher, std::move(known));
+    }
+}
+
+bool pool_idle(task_pool& pool) {
+    std::lock_guard<std::mutex> guard(pool.lock);
+    return pool.pending == 0;
+}
+
+void scan_apps() {
     if (!std::filesystem::is_directory(icon_cache)) {
         printf("The icon cache directory (%s) couldn't be found! Creating one...\n", icon_cache.string().c_str());
         std::filesystem::create_directory(icon_cache);
     }
 
-    for (auto& entry: std::filesystem::directory_iterator(apps)) {
-        if (entry.path().extension() == ".ipa") {
-            app app_entry;
-            app_entry.name = "Unknown App";
-            app_entry.version = "Unknown";
-            app_entry.filename = entry.path().filename().string();
-            app_entry.filepath = entry.path().string();
+    if (app_roots.empty()) {app_roots.push_back(apps);}
 
-            SDL_Texture* temp;
-            std::string cache_path = icon_cache.string() + "/" + app_entry.filename + ".png";
+    scan_state scan;
+    pool_start(scan.pool, pool_default_threads());
 
-            temp = IMG_LoadTexture(renderer, cache_path.c_str());
-
-            if (temp == NULL) {
-                printf("[!]: %s\n", IMG_GetError());
-                extract_icon(app_entry.filepath.c_str(), cache_path.c_str());
-                temp = IMG_LoadTexture(renderer, cache_path.c_str());
-            }
+    for (auto& root: app_roots) {
+        if (!std::filesystem::is_directory(root)) {
+            printf("[!] The apps directory (%s) couldn't be found!\n", root.string().c_str());
+            continue;
+        }
+        pool_push(scan.pool, [&scan, root] {scan_directory(scan, root);}, true);
+    }
 
-            app_entry.icon = temp;
+    // apps are added here on the render thread as results stream in; their icon textures
+    // are created later, as they scroll into view
+    while (true) {
+        std::vector<app> batch;
+        {
+            std::unique_lock<std::mutex> guard(scan.lock);
+            scan.ready.wait_for(guard, std::chrono::milliseconds(10), [&] {return !scan.done.empty();});
+            batch.swap(scan.done);
+        }
 
-            extract_plist_metadata(app_entry.filepath.c_str());
+        for (auto& result: batch) {store_add(apps_list, result);}
 
-            apps_list.push_back(app_entry);
+        // anything pushed before the pool went idle gets one last drain
+        if (batch.empty() && pool_idle(scan.pool)) {
+            std::lock_guard<std::mutex> guard(scan.lock);
+            if (scan.done.empty()) {break;}
         }
     }
 
-    apps_count = apps_list.size();
+    pool_stop(scan.pool);
+    seed_watchers(scan.files);
+    apps_count = apps_list.count;
+    rebuild_indices();
 }
 
 void reload_app_icons() {
-    // called when recreating the window
+    // called when recreating the window; load_visible_icons() brings them back as they're drawn
     for (int i = 0; i < apps_count; i++) {
-        SDL_DestroyTexture(apps_list[i].icon);
-        SDL_Texture* temp;
-        std::string cache_path = icon_cache.string() + "/" + apps_list[i].filename + ".png";
+        SDL_DestroyTexture(apps_list.icon[i]);
+        store_set_icon(apps_list, i, NULL);
+    }
+}
+
+int find_app(const std::string& filepath) {
+    return store_find(apps_list, filepath);
+}
+
+void set_app_icon(int i, SDL_Texture* icon) {
+    // an icon that won't load loses its swatch so it isn't retried every frame
+    store_set_icon(apps_list, i, icon);
+    if (icon == NULL) {apps_list.flags[i] &= ~APP_HAS_SWATCH;}
+}
+
+void queue_icon_load(const app& entry) {
+    int level = icon_level;
+    pending_icons.waiting[entry.filepath] = level;
+
+    pool_push(update_pool, [entry, level] {
+        SDL_Surface* surface = load_icon_surface(entry, level);
+        std::lock_guard<std::mutex> guard(pending_icons.lock);
+        pending_icons.done.push_back({entry.filepath, level, surface});
+    }, true);
+}
+
+void finish_icon_loads() {
+    // makes textures for the icons update_pool has loaded. ones for an app that's gone, already
+    // has its icon, or for a level we've since moved off of are dropped
+    std::vector<icon_load> done;
+    {
+        std::lock_guard<std::mutex> guard(pending_icons.lock);
+        done.swap(pending_icons.done);
+    }
+
+    for (icon_load& result : done) {
+        pending_icons.waiting.erase(result.filepath);
+        int i = find_app(result.filepath);
+        if (i < 0 || result.level != icon_level || (apps_list.flags[i] & APP_HAS_ICON)) {
+            SDL_FreeSurface(result.surface);
+            continue;
+        }
+        set_app_icon(i, icon_texture(result.surface));
+    }
+}
+
+// creates icon textures for the rows on screen from the icon cache, up to a few milliseconds'
+// worth per frame; rows still waiting show their swatch. icons not cached at this level yet
+// are queued with queue_icon_load() rather than extracted here
+const double ICON_LOAD_BUDGET_MS = 4;
+
+void load_visible_icons() {
+    finish_icon_loads();
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    int first, last;
+    update_layout();
+    list_visible(first, last);
+
+    for (int index = first; index < last; index++) {
+        int i = visible_apps[index];
+        if ((apps_list.flags[i] & (APP_HAS_ICON | APP_HAS_SWATCH)) != APP_HAS_SWATCH) {continue;}
+        app entry = store_get(apps_list, i);
+        if (pending_icons.waiting.count(entry.filepath)) {continue;}
+
+        std::string cache_path = icon_cache_file(icon_cache_base(entry), icon_level);
+        Uint64 t = SDL_GetPerformanceCounter();
+        SDL_Surface* surface = load_cached_icon(cache_path);
+        scan_stats.cache_load += SDL_GetPerformanceCounter() - t;
+
+        if (surface != NULL) {
+            set_app_icon(i, icon_texture(surface));
+        } else {
+            queue_icon_load(entry);
+        }
+
+        if ((SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency() > ICON_LOAD_BUDGET_MS) {break;}
+    }
+}
+
+void open_watchers() {
+    apps_watchers.clear();
+    apps_watchers.resize(app_roots.size());
+
+    for (size_t i = 0; i < app_roots.size(); i++) {
+        // scan_apps() and finish_rescan() seed them with what they listed
+        watcher_open(apps_watchers[i], app_roots[i], ".ipa", &update_pool, true);
+    }
+}
+
+void close_watchers() {
+    for (auto& watcher: apps_watchers) {watcher_close(watcher);}
+    apps_watchers.clear();
+}
+
+// reads path on the update pool; the entry is added or replaced once it's ready
+void queue_app_update(const std::string& path) {
+    Uint32 ticket = ++pending_updates.next_ticket;
+    pending_updates.waiting[path] = ticket;
+
+    pool_push(update_pool, [path, ticket] {
+        app result = make_app(path, false);
+        std::lock_guard<std::mutex> guard(pending_updates.lock);
+        pending_updates.done.push_back({ticket, result});
+    });
+}
 
-        temp = IMG_LoadTexture(renderer, cache_path.c_str());
+// adds the entries queue_app_update() has finished. returns true if the list changed
+bool finish_app_updates() {
+    std::vector<std::pair<Uint32, app>> batch;
+    {
+        std::lock_guard<std::mutex> guard(pending_updates.lock);
+        batch.swap(pending_updates.done);
+    }
+
+    bool changed = false;
+    for (auto& result: batch) {
+        auto waiting = pending_updates.waiting.find(result.second.filepath);
+        if (waiting == pending_updates.waiting.end() || waiting->second != result.first) {continue;}
+        pending_updates.waiting.erase(waiting);
+
+        app& entry = result.second;
+        app_history(entry);
+        int index = find_app(entry.filepath);
+        if (index >= 0) {
+            printf("Updated %s\n", entry.filepath.c_str());
+            SDL_DestroyTexture(apps_list.icon[index]);
+            list_set(index, entry);
+        } else {
+            printf("Added %s\n", entry.filepath.c_str());
+            list_add(entry);
+        }
+        changed = true;
+    }
+
+    apps_count = apps_list.count;
+    return changed;
+}
+
+void remove_app(int index) {
+    printf("Removed %s\n", store_path(apps_list, index).c_str());
+    SDL_DestroyTexture(apps_list.icon[index]);
+    remove_icon_cache(icon_cache_base(store_get(apps_list, index)));
+    list_remove(index);
+}
+
+// lists every root on update_pool; finish_rescan() picks up the result
+void start_rescan() {
+    auto job = std::make_shared<app_rescan>();
+    pending_rescan = job;
+
+    std::vector<std::filesystem::path> roots = app_roots;
+    pool_push(update_pool, [job, roots] {
+        std::map<std::string, file_stamp> files;
+        for (auto& root: roots) {
+            for (auto& file: watcher_snapshot(root, ".ipa")) {files[(root / file.first).string()] = file.second;}
+        }
+
+        std::lock_guard<std::mutex> guard(job->lock);
+        job->files.swap(files);
+        job->done = true;
+    });
+}
+
+// removes apps a finished rescan didn't find, and reads new or changed ones again like any other
+// update, so they stream in as they're ready. returns true if the list changed
+bool finish_rescan() {
+    if (pending_rescan == NULL) {return false;}
+
+    std::map<std::string, file_stamp> files;
+    {
+        std::lock_guard<std::mutex> guard(pending_rescan->lock);
+        if (!pending_rescan->done) {return false;}
+        files.swap(pending_rescan->files);
+    }
+    pending_rescan.reset();
+    seed_watchers(files);
+
+    bool changed = false;
+    for (int i = apps_list.count - 1; i >= 0; i--) {
+        if (files.find(store_path(apps_list, i)) == files.end()) {
+            remove_app(i);
+            changed = true;
+        }
+    }
+
+    for (auto waiting = pending_updates.waiting.begin(); waiting != pending_updates.waiting.end(); ) {
+        if (files.find(waiting->first) == files.end()) {waiting = pending_updates.waiting.erase(waiting);}
+        else {++waiting;}
+    }
+
+    std::unordered_map<std::string, int> indexed;
+    for (int i = 0; i < apps_list.count; i++) {indexed[store_path(apps_list, i)] = i;}
+
+    std::error_code err;
+    std::filesystem::create_directory(icon_cache, err);
+    for (auto& file: files) {
+        auto found = indexed.find(file.first);
+        long long mtime = std::chrono::duration_cast<std::chrono::seconds>(file.second.mtime.time_since_epoch()).count();
+        if (found != indexed.end() && apps_list.size[found->second] == file.second.size && apps_list.added[found->second] == mtime) {continue;}
+
+        if (found != indexed.end()) {remove_icon_cache(icon_cache_base(store_get(apps_list, found->second)));}
+        queue_app_update(file.first);
+    }
+
+    apps_count = apps_list.count;
+    return changed;
+}
+
+void apply_change(const dir_watcher& watcher, const watch_change& change) {
+    std::string path = (watcher.dir / change.name).string();
+    std::string old_path = (watcher.dir / change.old_name).string();
+    int index = change.type == WATCH_RENAMED ? find_app(old_path) : find_app(path);
+    std::error_code err;
+
+    switch (change.type) {
+        case WATCH_RESCAN:
+            break;
+
+        case WATCH_REMOVED:
+            pending_updates.waiting.erase(path);
+            if (index >= 0) {remove_app(index);}
+            break;
+
+        case WATCH_RENAMED:
+            pending_updates.waiting.erase(old_path);
+            if (index >= 0) {
+                // same file, so the cached icon just moves along with it
+                printf("Renamed %s to %s\n", old_path.c_str(), path.c_str());
+                app entry = store_get(apps_list, index);
+                std::string old_cache = icon_cache_base(entry);
+                entry.filename = std::filesystem::path(path).filename().string();
+                entry.filepath = path;
+                rename_icon_cache(old_cache, icon_cache_base(entry));
+                history_rename(history, old_path, path);
+                list_set(index, entry);
+                break;
+            }
+            index = find_app(path);
+            [[fallthrough]];
+
+        case WATCH_ADDED:
+        case WATCH_MODIFIED:
+            std::filesystem::create_directory(icon_cache, err);
+
+            // contents changed, so the cached icon (or lack of one) is stale. the old entry
+            // stays in the list until the new one has been read
+            if (index >= 0) {remove_icon_cache(icon_cache_base(store_get(apps_list, index)));}
+            queue_app_update(path);
+            break;
+    }
+
+    apps_count = apps_list.count;
+}
 
-        if (temp == NULL) {
-            printf("[!]: %s\n", IMG_GetError());
-            extract_icon(apps_list[i].filepath.c_str(), cache_path.c_str());
-            temp = IMG_LoadTexture(renderer, cache_path.c_str());
+void update_apps() {
+    // applies filesystem changes to apps_list without rescanning everything
+    bool changed = finish_app_updates();
+    changed = finish_rescan() || changed;
+    bool rescan = false;
+
+    for (auto& watcher: apps_watchers) {
+        std::vector<watch_change> changes;
+        watcher_poll(watcher, changes);
+
+        for (auto& change: changes) {
+            if (change.type == WATCH_RESCAN) {rescan = true; continue;}
+            apply_change(watcher, change);
+            changed = true;
         }
+    }
 
-        apps_list[i].icon = temp;
+    // events were dropped, so list everything again in the background; the watchers are
+    // reopened first, so nothing that happens meanwhile is missed
+    if (rescan) {
+        close_watchers();
+        open_watchers();
+        start_rescan();
+    }
+
+    if (changed) {filter_apps();}
+}
+
+void prefetch_recent() {
+    std::vector<int> recent;
+    for (int i = 0; i < apps_list.count; i++) {
+        if (apps_list.last_played[i] > 0) {recent.push_back(i);}
+    }
+
+    int count = std::min((int)recent.size(), PREFETCH_RECENT);
+    std::partial_sort(recent.begin(), recent.begin() + count, recent.end(), [](int a, int b) {
+        return apps_list.last_played[a] > apps_list.last_played[b];
+    });
+
+    for (int i = 0; i < count; i++) {prefetch_request(app_prefetch, store_path(apps_list, recent[i]), false);}
+}
+
+void update_hover_prefetch() {
+    int index = list_index_at(x, y);
+    int app = index >= 0 ? visible_apps[index] : -1;
+
+    if (app != hover_app) {
+        hover_app = app;
+        hover_since = SDL_GetTicks();
+        return;
+    }
+
+    // prefetch_request() ignores paths it has warmed recently, so asking every frame is fine
+    if (app >= 0 && SDL_GetTicks() - hover_since >= HOVER_DWELL_MS) {
+        prefetch_request(app_prefetch, store_path(apps_list, app), true);
     }
 }
 
 void launch_app() {
-    int app = (y/64) - scroll_offset;
-    if (app > apps_count-1) {return;}
-    std::string command = "touchHLE.exe \"" + apps_list[app].filepath + "\"";
+    int index = list_index_at(x, y);
+    if (index < 0) {return;}
+    int app = visible_apps[index];
+    std::string path = store_path(apps_list, app);
+
+    // launch the unpacked bundle when we have one, so touchHLE doesn't have to unzip the IPA
+    std::string bundle = bundle_cache_lookup(app_bundles, path);
+    std::string command = "touchHLE.exe \"" + (bundle.empty() ? path : bundle) + "\"";
 
     if (toggle_pause == true) {command += " & pause";}
 
     printf("%s", command.c_str());
 
-    system(command.c_str());
+    long long start = time(NULL);
+    int exit_code = system(command.c_str());
+    long long end = time(NULL);
+
+#ifndef _WIN32
+    if (WIFEXITED(exit_code)) {exit_code = WEXITSTATUS(exit_code);}
+#endif
+
+    history_record(history, path, start, end, exit_code);
+
+    const play_stats& stats = history.apps[path];
+    apps_list.play_count[app] = stats.count;
+    apps_list.playtime[app] = stats.total_seconds;
+    apps_list.last_played[app] = stats.last_played;
+    if (stats.last_quick) {apps_list.flags[app] |= APP_QUICK_EXIT;}
+    else {apps_list.flags[app] &= ~APP_QUICK_EXIT;}
+
+    // no point unpacking apps touchHLE can't run
+    if (stats.count >= BUNDLE_CACHE_MIN_PLAYS && !stats.last_quick) {bundle_cache_request(app_bundles, path);}
+}
+
+// matches the renderer's scale to the display's and picks the icon level to load for it.
+// returns true if the level changed, in which case the icons need reloading
+bool update_display_scale() {
+    int output_w, output_h, window_w, window_h;
+    SDL_GetRendererOutputSize(renderer, &output_w, &output_h);
+    SDL_GetWindowSize(window, &window_w, &window_h);
+    float scale = window_w > 0 ? (float)output_w / window_w : 1;
+    SDL_RenderSetScale(renderer, scale, scale);
+    // text layouts hold glyphs rasterised for the old density
+    if (scale != display_scale) {text_cache_clear(text_layouts);}
+    display_scale = scale;
+
+    int level = icon_levels[ICON_LEVEL_COUNT - 1];
+    for (int l = ICON_LEVEL_COUNT - 1; l >= 0; l--) {
+        if (icon_levels[l] >= ICON_DRAW_SIZE * scale) {level = icon_levels[l];}
+    }
+
+    bool changed = level != icon_level;
+    icon_level = level;
+    return changed;
 }
 
 bool init() {
@@ -402,23 +1851,41 @@ bool init() {
     SDL_SetHint(SDL_HINT_RENDER_VSYNC, "TRUE");
 
     // create window
-    window = SDL_CreateWindow("Shannon: A Basic TouchHLE Frontend", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_RESIZABLE);
+    // HiDPI: window coordinates stay in logical pixels, the renderer gets scaled up to match
+    SDL_SetHint("SDL_WINDOWS_DPI_SCALING", "1");
+    window = SDL_CreateWindow("Shannon: A Basic TouchHLE Frontend", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
 
     if (window == NULL) {
         printf("[!] Error creating window: %s\n", SDL_GetError());
         return false;
     }
 
-    // create renderer
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+    // create renderer. SDL leaves its software renderer out when asked for an accelerated one,
+    // so machines without a usable GPU need asking again
+    renderer = NULL;
+    if (!force_software) {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+        if (renderer == NULL) {printf("[!] No accelerated renderer (%s), using software rendering\n", SDL_GetError());}
+    }
+    if (renderer == NULL) {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+    }
 
     if (renderer == NULL) {
         printf("[!] Error creating renderer: %s\n", SDL_GetError());
         return false;
     }
 
+    // no GPU: redraw only what changes
+    SDL_RendererInfo info;
+    partial_redraw = allow_partial_redraw && SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_SOFTWARE);
+    animate_background = !partial_redraw || keep_animating;
+    dirty_all(frame_dirty);
+
     load_font();
+    update_display_scale();
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_StartTextInput();
 
     return true;
 }
@@ -429,79 +1896,215 @@ void kill() {
     SDL_Quit();
 }
 
+// the benchmarks in bench/ include this file directly and bring their own main()
+#ifndef SHANNON_NO_MAIN
 int main(int argc, char* args[]) {
     bool program_running = true;
     SDL_Event evt;
 
+    // --trace [file]: record a Chrome trace from startup, written on exit or F4
+    // --app-cache <MB>: keep unpacked copies of frequently played apps, up to this much disk
+    // --icon-cache qoi|raw: encoding for newly cached icons
+    // --full-redraw: redraw the whole window every frame even on the software renderer
+    // --software: use the software renderer even when hardware acceleration is available
+    // --animate-background: keep the background moving during partial redraws
+    // --apps <dir>: list IPAs from this directory instead of shannon_dirs.txt; may be repeated
+    //               (read by load_app_roots())
+    unsigned long long app_cache_mb = 0;
+    for (int i = 1; i < argc; i++) {
+        if (string(args[i]) == "--trace") {
+            if (i + 1 < argc && args[i + 1][0] != '-') {profiler.trace_path = args[++i];}
+            prof_start_trace();
+        }
+
+        if (string(args[i]) == "--app-cache" && i + 1 < argc) {
+            app_cache_mb = strtoull(args[++i], NULL, 10);
+        }
+
+        if (string(args[i]) == "--full-redraw") {allow_partial_redraw = false;}
+        if (string(args[i]) == "--software") {force_software = true;}
+        if (string(args[i]) == "--animate-background") {keep_animating = true;}
+
+        if (string(args[i]) == "--icon-cache" && i + 1 < argc) {
+            string encoding = args[++i];
+            for (int e = 0; e < ICON_ENCODING_COUNT; e++) {
+                if (encoding == icon_encoding_names[e]) {icon_encoding = e;}
+            }
+        }
+    }
+
+    load_app_roots(argc, args);
+    history_load(history, play_log_file.string(), play_stats_file.string());
+    bundle_cache_load(app_bundles, bundle_cache_dir, app_cache_mb << 20);
+
     if (!init()) {program_running = false; return 1;}
 
+    writer_start(icon_writer);
+    pool_start(update_pool, UPDATE_THREADS);
+    // watching starts before the scan, so nothing that changes during it is missed
+    open_watchers();
     scan_apps();
+    prefetch_start(app_prefetch);
+    prefetch_recent();
+
+    Uint64 last_frame = SDL_GetPerformanceCounter();
 
     while (program_running) {
-        while (SDL_PollEvent(&evt) != 0) {
-            switch (evt.type) {
-                case SDL_QUIT: program_running = false; break;
+        prof_frame();
+        update_apps();
+        update_hover_prefetch();
+        {
+            prof_scope scope(PROF_EVENTS);
+
+            while (SDL_PollEvent(&evt) != 0) {
+                switch (evt.type) {
+                    case SDL_QUIT: program_running = false; break;
+
+                    case SDL_WINDOWEVENT:
+                        // exposed, resized, restored...: whatever it is, redraw everything
+                        dirty_all(frame_dirty);
+                        if (evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                            SDL_RenderClear(renderer);
+                            SDL_GetWindowSize(window, &width, &height);
+                            text_cache_clear(text_layouts);
+                            scroll_set_range(list_scroll, list_scroll_max());
+                            // dragged onto a display with a different scale
+                            if (update_display_scale()) {reload_app_icons();}
+                        }
+                        break;
 
-                case SDL_WINDOWEVENT:
-                    if (evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-                        SDL_RenderClear(renderer);
-                        SDL_GetWindowSize(window, &width, &height);
-                        scroll_offset = 0;
-                    }
-                    break;
+                    // the row strips' contents are gone, though the textures survive
+                    case SDL_RENDER_TARGETS_RESET:
+                    case SDL_RENDER_DEVICE_RESET:
+                        row_cache_invalidate(list_rows);
+                        dirty_all(frame_dirty);
+                        break;
 
-                case SDL_MOUSEWHEEL:
-                    scroll_offset = fmax(fmin(0, scroll_offset + evt.wheel.y), -apps_count + ((float)(apps_count * 64) / height));
-                    break;
+                    case SDL_MOUSEWHEEL:
+                        scroll_by(list_scroll, -evt.wheel.y * app_layout.cell_h, SDL_GetTicks());
+                        break;
 
-                case SDL_MOUSEMOTION:
-                    SDL_GetMouseState(&x, &y);
+                    case SDL_MOUSEMOTION:
+                        SDL_GetMouseState(&x, &y);
 
-                    break;
+                        break;
 
-                case SDL_MOUSEBUTTONDOWN:
-                    if (x > width || x < 0 || y > height || y < 0 || apps_count == 0) {break;}
+                    case SDL_MOUSEBUTTONDOWN:
+                        if (x > width || x < 0 || y > height || y < 0) {break;}
 
-                    if (y > height - 24) {
-                        if (x > 2 && x < 22 && y > height-22 && y < height-2) {
-                            toggle_pause = !toggle_pause;
+                        if (y > height - 24) {
+                            if (x > 2 && x < 22 && y > height-22 && y < height-2) {
+                                toggle_pause = !toggle_pause;
+                            }
+                            break;
                         }
+
+                        if (list_index_at(x, y) < 0) {break;}
+
+                        if (evt.button.button == SDL_BUTTON_LEFT) {
+                            row_cache_clear(list_rows);
+                            SDL_DestroyRenderer(renderer);
+                            SDL_DestroyWindow(window);
+                            launch_app();
+                            init();
+                            reload_app_icons();
+                            rebuild_sort_orders();
+                            filter_apps();
+                        }
+                        break;
+
+                    case SDL_TEXTINPUT:
+                        search_query += evt.text.text;
+                        scroll_jump(list_scroll, 0);
+                        filter_apps();
                         break;
-                    }
 
-                    if (y > (apps_count*64) + (scroll_offset*64)) {break;}
+                    case SDL_KEYDOWN:
+                        if (evt.key.keysym.sym == SDLK_PAGEUP) {
+                            scroll_by(list_scroll, -5 * app_layout.cell_h, SDL_GetTicks());
+                        }
+
+                        if (evt.key.keysym.sym == SDLK_PAGEDOWN) {
+                            scroll_by(list_scroll, 5 * app_layout.cell_h, SDL_GetTicks());
+                        }
+
+                        // backspace deletes a whole UTF-8 character, escape clears the search
+                        if (evt.key.keysym.sym == SDLK_BACKSPACE && !search_query.empty()) {
+                            while (search_query.size() > 1 && (search_query.back() & 0xC0) == 0x80) {search_query.pop_back();}
+                            search_query.pop_back();
+                            scroll_jump(list_scroll, 0);
+                            filter_apps();
+                        }
 
-                    if (evt.button.button == SDL_BUTTON_LEFT) {
-                        SDL_DestroyRenderer(renderer);
-                        SDL_DestroyWindow(window);
-                        launch_app();
-                        init();
-                        reload_app_icons();
-                    }
-                    break;
+                        if (evt.key.keysym.sym == SDLK_F5) {
+                            current_sort = (current_sort + 1) % SORT_MODE_COUNT;
+                            scroll_jump(list_scroll, 0);
+                            filter_apps();
+                        }
 
-                case SDL_KEYDOWN:
-                    if (evt.key.keysym.sym == SDLK_PAGEUP) {
-                        scroll_offset = fmax(fmin(0, scroll_offset + 5), -apps_count + ((float)(apps_count * 64) / height));
-                    }
+                        if (evt.key.keysym.sym == SDLK_F6) {
+                            group_by_folder = !group_by_folder;
+                            rebuild_sort_orders();
+                            filter_apps();
+                        }
 
-                    if (evt.key.keysym.sym == SDLK_PAGEDOWN) {
-                        scroll_offset = fmax(fmin(0, scroll_offset + -5), -apps_count + ((float)(apps_count * 64) / height));
-                    }
+                        // F7 switches between the list and the grid, keeping the top app in view
+                        if (evt.key.keysym.sym == SDLK_F7) {
+                            int first, last;
+                            list_visible(first, last);
+                            app_layout.mode = (app_layout.mode + 1) % LAYOUT_MODE_COUNT;
+                            scroll_set_range(list_scroll, list_scroll_max());
+                            scroll_jump(list_scroll, layout_cell(app_layout, first, 0).y);
+                        }
+
+                        if (evt.key.keysym.sym == SDLK_TAB) {
+                            fuzzy_search = !fuzzy_search;
+                            filter_apps();
+                        }
 
-                    break;
+                        if (evt.key.keysym.sym == SDLK_ESCAPE && !search_query.empty()) {
+                            search_query.clear();
+                            scroll_jump(list_scroll, 0);
+                            filter_apps();
+                        }
+
+                        // F3 shows the profiler overlay, F4 starts/stops a trace capture
+                        if (evt.key.keysym.sym == SDLK_F3) {
+                            profiler.overlay = !profiler.overlay;
+                        }
+
+                        if (evt.key.keysym.sym == SDLK_F4) {
+                            if (profiler.tracing) {prof_write_trace();}
+                            else {prof_start_trace();}
+                        }
+
+                        break;
+                }
             }
         }
 
-        display_background();
-        display_list();
-        display_options_bar();
-        //draw_text(std::to_string(x), width, 0,  1, -1, width, {255, 255, 96});
-        //draw_text(std::to_string(y), width, 16, 1, -1, width, {255, 255, 96});
+        // scrolling moves by elapsed time, not by frame
+        Uint64 now = SDL_GetPerformanceCounter();
+        float dt = std::min(0.1, (double)(now - last_frame) / SDL_GetPerformanceFrequency());
+        last_frame = now;
+        scroll_set_range(list_scroll, list_scroll_max());
+        scroll_update(list_scroll, dt);
 
-        SDL_RenderPresent(renderer);
+        load_visible_icons();
+        display_frame();
     }
 
+    if (profiler.tracing) {prof_write_trace();}
+
+    prefetch_stop(app_prefetch);
+    close_watchers();
+    pool_stop(update_pool);
+    for (icon_load& result : pending_icons.done) {SDL_FreeSurface(result.surface);}
+    writer_stop(icon_writer);
+    bundle_cache_close(app_bundles);
+    row_cache_clear(list_rows);
+    atlas_close(font_atlas);
     kill();
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,151 @@
+// Play history. Every launch appends one line to a log file; at startup the
+// log is replayed on top of a per-app aggregate file, and once the log gets
+// long it's folded into the aggregates and truncated. Reading history is
+// therefore one small file plus a short log, no matter how long Shannon has
+// been in use.
+//
+// log lines:        start end exit_code key
+// aggregate lines:  count total_seconds last_played quick_exits last_exit last_quick key
+// keys are the IPA path and go last so they can contain spaces.
+
+#ifndef SHANNON_PLAY_HISTORY_H
+#define SHANNON_PLAY_HISTORY_H
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+// a session shorter than this that exits with an error counts as touchHLE giving up on the
+// app straight away; a quick clean exit is just the player closing it
+const long long QUICK_EXIT_SECONDS = 10;
+// fold the log into the aggregates once it has this many lines
+const int HISTORY_COMPACT_AFTER = 64;
+
+struct play_stats {
+    int count = 0;
+    long long total_seconds = 0;
+    long long last_played = 0;
+    int quick_exits = 0;
+    int last_exit = 0;
+    bool last_quick = false;
+};
+
+struct play_history {
+    std::string log_path;
+    std::string stats_path;
+    std::unordered_map<std::string, play_stats> apps;
+    int log_entries = 0;
+};
+
+void history_apply(play_history& history, const std::string& key, long long start, long long end, int exit_code) {
+    play_stats& stats = history.apps[key];
+    long long seconds = end > start ? end - start : 0;
+
+    stats.count++;
+    stats.total_seconds += seconds;
+    stats.last_played = std::max(stats.last_played, start);
+    stats.last_exit = exit_code;
+    stats.last_quick = seconds < QUICK_EXIT_SECONDS && exit_code != 0;
+    if (stats.last_quick) {stats.quick_exits++;}
+}
+
+// reads everything after the numeric fields, minus the separating space
+std::string history_key(std::istringstream& line) {
+    std::string key;
+    std::getline(line, key);
+    if (!key.empty() && key[0] == ' ') {key.erase(0, 1);}
+    if (!key.empty() && key.back() == '\r') {key.pop_back();}
+    return key;
+}
+
+bool history_compact(play_history& history) {
+    // write aggregates to a temp file and swap it in, then drop the log
+    std::string temp_path = history.stats_path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "w");
+    if (file == NULL) {return false;}
+
+    for (auto& entry: history.apps) {
+        const play_stats& stats = entry.second;
+        fprintf(file, "%d %lld %lld %d %d %d %s\n", stats.count, stats.total_seconds, stats.last_played,
+                stats.quick_exits, stats.last_exit, stats.last_quick ? 1 : 0, entry.first.c_str());
+    }
+
+    bool ok = fclose(file) == 0;
+    std::error_code err;
+    if (ok) {std::filesystem::rename(temp_path, history.stats_path, err);}
+    if (!ok || err) {
+        std::filesystem::remove(temp_path, err);
+        return false;
+    }
+
+    std::filesystem::remove(history.log_path, err);
+    history.log_entries = 0;
+    return true;
+}
+
+void history_load(play_history& history, const std::string& log_path, const std::string& stats_path) {
+    history.log_path = log_path;
+    history.stats_path = stats_path;
+    history.apps.clear();
+    history.log_entries = 0;
+
+    std::ifstream stats_file(stats_path);
+    std::string text;
+    while (std::getline(stats_file, text)) {
+        std::istringstream line(text);
+        play_stats stats;
+        int last_quick = 0;
+        if (!(line >> stats.count >> stats.total_seconds >> stats.last_played >> stats.quick_exits >> stats.last_exit >> last_quick)) {continue;}
+        stats.last_quick = last_quick != 0;
+
+        std::string key = history_key(line);
+        if (!key.empty()) {history.apps[key] = stats;}
+    }
+
+    std::ifstream log_file(log_path);
+    while (std::getline(log_file, text)) {
+        std::istringstream line(text);
+        long long start, end;
+        int exit_code;
+        if (!(line >> start >> end >> exit_code)) {continue;}
+
+        std::string key = history_key(line);
+        if (key.empty()) {continue;}
+        history_apply(history, key, start, end, exit_code);
+        history.log_entries++;
+    }
+    log_file.close();
+
+    if (history.log_entries >= HISTORY_COMPACT_AFTER) {history_compact(history);}
+}
+
+void history_record(play_history& history, const std::string& key, long long start, long long end, int exit_code) {
+    history_apply(history, key, start, end, exit_code);
+
+    FILE* file = fopen(history.log_path.c_str(), "a");
+    if (file == NULL) {
+        printf("[!] Couldn't write play history to %s\n", history.log_path.c_str());
+        return;
+    }
+    fprintf(file, "%lld %lld %d %s\n", start, end, exit_code, key.c_str());
+    fclose(file);
+
+    if (++history.log_entries >= HISTORY_COMPACT_AFTER) {history_compact(history);}
+}
+
+// moves an app's history to a new key, e.g. when its IPA gets renamed
+void history_rename(play_history& history, const std::string& old_key, const std::string& new_key) {
+    auto found = history.apps.find(old_key);
+    if (found == history.apps.end()) {return;}
+
+    play_stats stats = found->second;
+    history.apps.erase(found);
+    history.apps[new_key] = stats;
+    history_compact(history);
+}
+
+#endif
@@ -0,0 +1,325 @@
+// Small reader for Apple property lists, both XML and binary ("bplist00").
+// Only what Shannon needs: strings, arrays and dicts come through as-is,
+// everything else (numbers, dates, data, bools) is kept as an opaque value
+// whose str holds a best-effort text form. IPAs are untrusted input, so every
+// offset is bounds-checked and nesting depth is capped.
+
+#ifndef SHANNON_PLIST_H
+#define SHANNON_PLIST_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct plist_value {
+    enum kind_t {NONE, STRING, ARRAY, DICT, OTHER};
+    kind_t kind = NONE;
+    std::string str;
+    std::vector<plist_value> items;                           // ARRAY
+    std::vector<std::pair<std::string, plist_value>> dict;   // DICT
+};
+
+const int PLIST_MAX_DEPTH = 32;
+const int PLIST_MAX_OBJECTS = 100000;   // binary plists can reference objects more than once
+
+const plist_value* plist_get(const plist_value& dict, const char* key) {
+    if (dict.kind != plist_value::DICT) {return NULL;}
+    for (auto& kv: dict.dict) {
+        if (kv.first == key) {return &kv.second;}
+    }
+    return NULL;
+}
+
+std::string plist_get_string(const plist_value& dict, const char* key) {
+    const plist_value* value = plist_get(dict, key);
+    return value != NULL && value->kind == plist_value::STRING ? value->str : "";
+}
+
+void plist_append_utf8(std::string& out, unsigned int cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+// ---------------------------------------------------------------- binary
+
+struct bplist_reader {
+    const unsigned char* data;
+    size_t size;
+    int offset_size;
+    int ref_size;
+    unsigned long long objects;
+    unsigned long long table;
+    int budget;
+};
+
+bool bplist_uint(const bplist_reader& r, size_t pos, int bytes, unsigned long long& out) {
+    if (bytes < 1 || bytes > 8 || pos > r.size || r.size - pos < (size_t)bytes) {return false;}
+    out = 0;
+    for (int i = 0; i < bytes; i++) {out = (out << 8) | r.data[pos + i];}
+    return true;
+}
+
+// reads the length of an object whose marker low nibble is 0xF (followed by an int object)
+bool bplist_length(const bplist_reader& r, size_t& pos, unsigned long long& out) {
+    unsigned char nibble = r.data[pos] & 0x0F;
+    pos++;
+    if (nibble != 0x0F) {out = nibble; return true;}
+
+    if (pos >= r.size || (r.data[pos] & 0xF0) != 0x10) {return false;}
+    int bytes = 1 << (r.data[pos] & 0x0F);
+    pos++;
+    if (!bplist_uint(r, pos, bytes, out)) {return false;}
+    pos += bytes;
+    return true;
+}
+
+bool bplist_object(bplist_reader& r, unsigned long long ref, plist_value& out, int depth) {
+    if (depth > PLIST_MAX_DEPTH || ref >= r.objects || --r.budget < 0) {return false;}
+
+    unsigned long long offset;
+    if (!bplist_uint(r, r.table + ref * r.offset_size, r.offset_size, offset)) {return false;}
+    if (offset >= r.size) {return false;}
+
+    size_t pos = offset;
+    unsigned char marker = r.data[pos];
+    unsigned long long length;
+
+    switch (marker >> 4) {
+        case 0x1: {
+            // integer
+            unsigned long long value;
+            if (!bplist_uint(r, pos + 1, 1 << (marker & 0x0F), value)) {return false;}
+            out.kind = plist_value::OTHER;
+            out.str = std::to_string(value);
+            return true;
+        }
+
+        case 0x5:
+            // ASCII string
+            if (!bplist_length(r, pos, length) || length > r.size - pos) {return false;}
+            out.kind = plist_value::STRING;
+            out.str.assign((const char*)r.data + pos, length);
+            return true;
+
+        case 0x6:
+            // UTF-16BE string, length counts code units
+            if (!bplist_length(r, pos, length) || length > (r.size - pos) / 2) {return false;}
+            out.kind = plist_value::STRING;
+            out.str.clear();
+            for (unsigned long long i = 0; i < length; i++) {
+                unsigned int unit = (r.data[pos + i*2] << 8) | r.data[pos + i*2 + 1];
+                if (unit >= 0xD800 && unit < 0xDC00 && i + 1 < length) {
+                    unsigned int low = (r.data[pos + i*2 + 2] << 8) | r.data[pos + i*2 + 3];
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                        i++;
+                    }
+                }
+                plist_append_utf8(out.str, unit);
+            }
+            return true;
+
+        case 0xA:
+        case 0xD: {
+            // array, or dict (keys then values)
+            bool is_dict = (marker >> 4) == 0xD;
+            if (!bplist_length(r, pos, length)) {return false;}
+            unsigned long long refs = is_dict ? length * 2 : length;
+            if (length > r.size || refs > (r.size - pos) / r.ref_size) {return false;}
+
+            out.kind = is_dict ? plist_value::DICT : plist_value::ARRAY;
+            for (unsigned long long i = 0; i < length; i++) {
+                // for dicts this first ref is the key, and the value ref is `length` refs later
+                unsigned long long ref;
+                plist_value item;
+                if (!bplist_uint(r, pos + i * r.ref_size, r.ref_size, ref)) {return false;}
+                if (!bplist_object(r, ref, item, depth + 1)) {return false;}
+
+                if (!is_dict) {
+                    out.items.push_back(item);
+                    continue;
+                }
+
+                plist_value value;
+                if (!bplist_uint(r, pos + (length + i) * r.ref_size, r.ref_size, ref)) {return false;}
+                if (!bplist_object(r, ref, value, depth + 1)) {return false;}
+                out.dict.push_back({item.str, value});
+            }
+            return true;
+        }
+
+        case 0x0:
+            out.kind = plist_value::OTHER;
+            out.str = marker == 0x09 ? "true" : marker == 0x08 ? "false" : "";
+            return true;
+
+        default:
+            // reals, dates, data, UIDs, sets: nothing we read
+            out.kind = plist_value::OTHER;
+            return true;
+    }
+}
+
+bool plist_parse_binary(const char* data, size_t size, plist_value& out) {
+    if (size < 8 + 32 || memcmp(data, "bplist00", 8) != 0) {return false;}
+
+    bplist_reader r;
+    r.data = (const unsigned char*)data;
+    r.size = size;
+    r.budget = PLIST_MAX_OBJECTS;
+
+    const unsigned char* trailer = r.data + size - 32;
+    r.offset_size = trailer[6];
+    r.ref_size = trailer[7];
+
+    unsigned long long top;
+    if (!bplist_uint(r, size - 24, 8, r.objects) || !bplist_uint(r, size - 16, 8, top) || !bplist_uint(r, size - 8, 8, r.table)) {return false;}
+    if (r.offset_size < 1 || r.offset_size > 8 || r.ref_size < 1 || r.ref_size > 8) {return false;}
+    if (r.table >= size || r.objects > (size - r.table) / r.offset_size) {return false;}
+
+    return bplist_object(r, top, out, 0);
+}
+
+// ---------------------------------------------------------------- XML
+
+struct xplist_reader {
+    std::string_view data;
+    size_t pos;
+};
+
+std::string xplist_unescape(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+
+    for (size_t i = 0; i < text.size(); i++) {
+        size_t end = text[i] == '&' ? text.find(';', i) : std::string_view::npos;
+        if (end == std::string_view::npos) {out += text[i]; continue;}
+
+        std::string entity(text.substr(i + 1, end - i - 1));
+        if (entity == "amp") {out += '&';}
+        else if (entity == "lt") {out += '<';}
+        else if (entity == "gt") {out += '>';}
+        else if (entity == "quot") {out += '"';}
+        else if (entity == "apos") {out += '\'';}
+        else if (entity.size() > 1 && entity[0] == '#') {
+            unsigned long cp = entity[1] == 'x' ? strtoul(entity.c_str() + 2, NULL, 16) : strtoul(entity.c_str() + 1, NULL, 10);
+            if (cp > 0 && cp < 0x110000) {plist_append_utf8(out, cp);}
+        } else {
+            out.append(text.substr(i, end - i + 1));
+        }
+        i = end;
+    }
+
+    return out;
+}
+
+// moves to the next element tag, skipping text, comments, <?...?> and <!...>
+// returns the tag name (with a leading '/' for closing tags), and whether it's self-closing
+bool xplist_tag(xplist_reader& r, std::string& name, bool& self_closing) {
+    while (true) {
+        size_t open = r.data.find('<', r.pos);
+        if (open == std::string_view::npos) {return false;}
+
+        if (r.data.compare(open, 4, "<!--") == 0) {
+            size_t end = r.data.find("-->", open);
+            if (end == std::string_view::npos) {return false;}
+            r.pos = end + 3;
+            continue;
+        }
+
+        size_t close = r.data.find('>', open);
+        if (close == std::string_view::npos) {return false;}
+        r.pos = close + 1;
+
+        std::string_view tag = r.data.substr(open + 1, close - open - 1);
+        if (tag.empty() || tag[0] == '?' || tag[0] == '!') {continue;}
+
+        self_closing = tag.back() == '/';
+        name = std::string(tag.substr(0, tag.find_first_of(" \t\r\n/", tag[0] == '/' ? 1 : 0)));
+        return true;
+    }
+}
+
+// text up to the matching closing tag, which is consumed
+bool xplist_text(xplist_reader& r, const std::string& tag, std::string& out) {
+    std::string closing = "</" + tag + ">";
+    size_t end = r.data.find(closing, r.pos);
+    if (end == std::string_view::npos) {return false;}
+
+    out = xplist_unescape(r.data.substr(r.pos, end - r.pos));
+    r.pos = end + closing.size();
+    return true;
+}
+
+bool xplist_value(xplist_reader& r, const std::string& tag, bool self_closing, plist_value& out, int depth) {
+    if (depth > PLIST_MAX_DEPTH) {return false;}
+
+    if (tag == "dict" || tag == "array") {
+        bool is_dict = tag == "dict";
+        out.kind = is_dict ? plist_value::DICT : plist_value::ARRAY;
+        if (self_closing) {return true;}
+
+        std::string name, key;
+        bool empty;
+        while (xplist_tag(r, name, empty)) {
+            if (name == "/dict" || name == "/array") {return true;}
+
+            if (is_dict && name == "key") {
+                if (empty) {key.clear(); continue;}
+                if (!xplist_text(r, "key", key)) {return false;}
+                continue;
+            }
+
+            plist_value item;
+            if (!xplist_value(r, name, empty, item, depth + 1)) {return false;}
+            if (is_dict) {out.dict.push_back({key, item});}
+            else {out.items.push_back(item);}
+        }
+        return false;
+    }
+
+    if (tag == "string") {
+        out.kind = plist_value::STRING;
+        return self_closing || xplist_text(r, "string", out.str);
+    }
+
+    out.kind = plist_value::OTHER;
+    if (tag == "true" || tag == "false") {out.str = tag; return true;}
+    return self_closing || xplist_text(r, tag, out.str);
+}
+
+bool plist_parse_xml(const char* data, size_t size, plist_value& out) {
+    xplist_reader r = {std::string_view(data, size), 0};
+    std::string name;
+    bool self_closing;
+
+    while (xplist_tag(r, name, self_closing)) {
+        if (name == "plist") {continue;}
+        return xplist_value(r, name, self_closing, out, 0);
+    }
+    return false;
+}
+
+bool plist_parse(const char* data, size_t size, plist_value& out) {
+    if (data == NULL) {return false;}
+    if (size >= 8 && memcmp(data, "bplist00", 8) == 0) {return plist_parse_binary(data, size, out);}
+    return plist_parse_xml(data, size, out);
+}
+
+#endif
@@ -0,0 +1,133 @@
+// Warms IPAs into the OS page cache before they're launched, so touchHLE
+// doesn't have to read them cold from slow storage. Requests go to a single
+// background thread, which asks the kernel for readahead where it can
+// (posix_fadvise WILLNEED) and otherwise just reads the file through once.
+// Total I/O is capped per time window so hovering over the list doesn't turn
+// into reading the whole library.
+
+#ifndef SHANNON_PREFETCH_H
+#define SHANNON_PREFETCH_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const Uint64 PREFETCH_BUDGET_BYTES = 512ull << 20;  // per window
+const Uint32 PREFETCH_WINDOW_MS = 60000;
+const Uint32 PREFETCH_REPEAT_MS = 300000;           // don't re-warm the same file for this long
+const size_t PREFETCH_QUEUE_MAX = 8;
+
+struct prefetcher {
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::string> queue;
+    std::unordered_map<std::string, Uint32> warmed;   // path -> SDL_GetTicks() when the budget let it through
+    bool stopping = false;
+
+    // only touched by the worker
+    Uint64 window_bytes = 0;
+    Uint32 window_start = 0;
+};
+
+bool prefetch_file(prefetcher& pf, const std::string& path) {
+#if defined(POSIX_FADV_WILLNEED)
+    // asynchronous: the kernel schedules readahead and we return straight away
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {return false;}
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+    return true;
+#else
+    // no readahead hint available, so read it through ourselves, bailing out on shutdown
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL) {return false;}
+
+    std::vector<char> chunk(1 << 20);
+    while (fread(chunk.data(), 1, chunk.size(), file) == chunk.size()) {
+        std::lock_guard<std::mutex> guard(pf.lock);
+        if (pf.stopping) {break;}
+    }
+    fclose(file);
+    return true;
+#endif
+}
+
+void prefetch_worker(prefetcher& pf) {
+    while (true) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> guard(pf.lock);
+            pf.wake.wait(guard, [&] {return pf.stopping || !pf.queue.empty();});
+            if (pf.stopping) {return;}
+
+            path = pf.queue.front();
+            pf.queue.pop_front();
+        }
+
+        Uint32 now = SDL_GetTicks();
+        if (now - pf.window_start > PREFETCH_WINDOW_MS) {
+            pf.window_start = now;
+            pf.window_bytes = 0;
+        }
+
+        std::error_code err;
+        Uint64 size = std::filesystem::file_size(path, err);
+        if (err || pf.window_bytes + size > PREFETCH_BUDGET_BYTES) {continue;}
+
+        // only files that actually got warmed are held back from being asked for again
+        {
+            std::lock_guard<std::mutex> guard(pf.lock);
+            pf.warmed[path] = now;
+        }
+        if (prefetch_file(pf, path)) {pf.window_bytes += size;}
+    }
+}
+
+void prefetch_start(prefetcher& pf) {
+    pf.stopping = false;
+    pf.window_start = SDL_GetTicks();
+    pf.worker = std::thread(prefetch_worker, std::ref(pf));
+}
+
+// urgent requests (the app under the mouse) go ahead of background ones (recently played)
+void prefetch_request(prefetcher& pf, const std::string& path, bool urgent) {
+    std::lock_guard<std::mutex> guard(pf.lock);
+    Uint32 now = SDL_GetTicks();
+
+    auto warmed = pf.warmed.find(path);
+    if (warmed != pf.warmed.end() && now - warmed->second < PREFETCH_REPEAT_MS) {return;}
+    if (std::find(pf.queue.begin(), pf.queue.end(), path) != pf.queue.end()) {return;}
+
+    if (urgent) {pf.queue.push_front(path);}
+    else {pf.queue.push_back(path);}
+
+    // stale requests fall off the back
+    while (pf.queue.size() > PREFETCH_QUEUE_MAX) {pf.queue.pop_back();}
+    pf.wake.notify_one();
+}
+
+void prefetch_stop(prefetcher& pf) {
+    {
+        std::lock_guard<std::mutex> guard(pf.lock);
+        pf.stopping = true;
+        pf.queue.clear();
+    }
+    pf.wake.notify_all();
+    if (pf.worker.joinable()) {pf.worker.join();}
+}
+
+#endif
@@ -0,0 +1,131 @@
+// Built-in frame profiler: scoped timers around the main loop's stages,
+// per-frame draw call counting, and Chrome trace export (chrome://tracing or
+// https://ui.perfetto.dev can open the resulting JSON file).
+
+#ifndef SHANNON_PROFILER_H
+#define SHANNON_PROFILER_H
+
+#include <SDL2/SDL.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum prof_zone {
+    PROF_EVENTS,
+    PROF_BACKGROUND,
+    PROF_LIST,
+    PROF_TEXT,
+    PROF_PRESENT,
+    PROF_ZONE_COUNT
+};
+
+const char* prof_zone_names[PROF_ZONE_COUNT] = {"events", "display_background", "display_list", "draw_text", "present"};
+
+const int PROF_HISTORY = 240;           // frames kept for the histogram
+const size_t PROF_MAX_EVENTS = 1 << 20; // trace stops recording once this is hit
+
+struct trace_event {
+    int zone;
+    Uint64 start;
+    Uint64 duration;
+};
+
+struct profiler_state {
+    bool overlay = false;
+    bool tracing = false;
+    std::string trace_path = "shannon_trace.json";
+
+    // totals for the frame in progress, copied into last_* when it ends
+    Uint64 zone_ticks[PROF_ZONE_COUNT] = {0};
+    int draw_calls = 0;
+
+    Uint64 last_zone_ticks[PROF_ZONE_COUNT] = {0};
+    int last_draw_calls = 0;
+
+    Uint64 frame_start = 0;
+    float frame_ms[PROF_HISTORY] = {0};
+    int frame_index = 0;
+
+    Uint64 trace_origin = 0;
+    std::vector<trace_event> trace;
+};
+
+profiler_state profiler;
+
+// times the enclosing block; nested scopes are counted in both zones
+struct prof_scope {
+    int zone;
+    Uint64 start;
+
+    prof_scope(int z) : zone(z), start(SDL_GetPerformanceCounter()) {}
+
+    ~prof_scope() {
+        Uint64 duration = SDL_GetPerformanceCounter() - start;
+        profiler.zone_ticks[zone] += duration;
+
+        if (profiler.tracing && profiler.trace.size() < PROF_MAX_EVENTS) {
+            profiler.trace.push_back({zone, start, duration});
+        }
+    }
+};
+
+double prof_ms(Uint64 ticks) {
+    return (double)ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// call once per frame, right before the event loop
+void prof_frame() {
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (profiler.frame_start != 0) {
+        profiler.frame_ms[profiler.frame_index] = prof_ms(now - profiler.frame_start);
+        profiler.frame_index = (profiler.frame_index + 1) % PROF_HISTORY;
+    }
+    profiler.frame_start = now;
+
+    for (int i = 0; i < PROF_ZONE_COUNT; i++) {
+        profiler.last_zone_ticks[i] = profiler.zone_ticks[i];
+        profiler.zone_ticks[i] = 0;
+    }
+    profiler.last_draw_calls = profiler.draw_calls;
+    profiler.draw_calls = 0;
+}
+
+void prof_start_trace() {
+    profiler.trace.clear();
+    profiler.trace_origin = SDL_GetPerformanceCounter();
+    profiler.tracing = true;
+    printf("Recording trace to %s...\n", profiler.trace_path.c_str());
+}
+
+bool prof_write_trace() {
+    profiler.tracing = false;
+
+    FILE* file = fopen(profiler.trace_path.c_str(), "w");
+    if (file == NULL) {
+        printf("[!] Couldn't write trace file %s\n", profiler.trace_path.c_str());
+        return false;
+    }
+
+    // Chrome trace "complete" events, timestamps in microseconds
+    double us_per_tick = 1000000.0 / SDL_GetPerformanceFrequency();
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    for (size_t i = 0; i < profiler.trace.size(); i++) {
+        const trace_event& evt = profiler.trace[i];
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                prof_zone_names[evt.zone],
+                (evt.start - profiler.trace_origin) * us_per_tick,
+                evt.duration * us_per_tick,
+                i + 1 < profiler.trace.size() ? "," : "");
+    }
+
+    fprintf(file, "]}\n");
+    fclose(file);
+
+    printf("Wrote %d trace events to %s\n", (int)profiler.trace.size(), profiler.trace_path.c_str());
+    profiler.trace.clear();
+    return true;
+}
+
+#endif
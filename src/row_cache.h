@@ -0,0 +1,125 @@
+// Pre-rendered rows for the app list. Each row on screen (icon, filename,
+// stats) is drawn once into a strip-shaped render target and after that just
+// copied to the screen, so a frame costs one blit per row however much text
+// it holds. Strips come from a small pool sized to what's on screen, keyed by
+// app index and tagged with a signature of everything drawn in them; a row is
+// only redrawn when its signature changes, and the whole pool is dropped when
+// the strip size does (window resized or moved to another display scale).
+//
+// Strips start out transparent, so what's drawn into them ends up with its
+// colour premultiplied by alpha; they're copied out with a premultiplied blend
+// mode where the renderer supports custom ones, and plain blending otherwise.
+
+#ifndef SHANNON_ROW_CACHE_H
+#define SHANNON_ROW_CACHE_H
+
+#include <SDL2/SDL.h>
+#include <cstring>
+#include <vector>
+
+struct row_strip {
+    SDL_Texture* texture = NULL;
+    int key = -1;               // -1 for a strip with nothing useful in it
+    Uint64 signature = 0;
+    Uint32 last_used = 0;       // frame number
+};
+
+struct row_cache {
+    std::vector<row_strip> strips;
+    int w = 0, h = 0;           // strip size in real pixels
+    size_t capacity = 0;
+    Uint32 frame = 0;
+    SDL_BlendMode blend = SDL_BLENDMODE_INVALID;
+};
+
+// FNV-1a, for building row signatures a field at a time
+Uint64 row_hash(Uint64 hash, const void* data, size_t size) {
+    const Uint8* bytes = (const Uint8*)data;
+    for (size_t i = 0; i < size; i++) {hash = (hash ^ bytes[i]) * 1099511628211ull;}
+    return hash;
+}
+
+const Uint64 ROW_HASH_SEED = 14695981039346656037ull;
+
+// destroys every strip; call before the renderer goes away
+void row_cache_clear(row_cache& cache) {
+    for (row_strip& strip: cache.strips) {SDL_DestroyTexture(strip.texture);}
+    cache.strips.clear();
+    cache.blend = SDL_BLENDMODE_INVALID;
+}
+
+// keeps the textures but forgets what's in them, e.g. after the renderer lost its targets
+void row_cache_invalidate(row_cache& cache) {
+    for (row_strip& strip: cache.strips) {strip.key = -1;}
+}
+
+// starts a frame of strips w by h, keeping at most capacity of them
+void row_cache_begin(row_cache& cache, int w, int h, size_t capacity) {
+    if (w != cache.w || h != cache.h) {
+        row_cache_clear(cache);
+        cache.w = w;
+        cache.h = h;
+    }
+
+    // window got shorter: drop the least recently used strips
+    while (cache.strips.size() > capacity) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < cache.strips.size(); i++) {
+            if (cache.strips[i].last_used < cache.strips[oldest].last_used) {oldest = i;}
+        }
+        SDL_DestroyTexture(cache.strips[oldest].texture);
+        cache.strips.erase(cache.strips.begin() + oldest);
+    }
+
+    cache.capacity = capacity;
+    cache.frame++;
+}
+
+SDL_Texture* row_cache_create(row_cache& cache, SDL_Renderer* renderer) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, cache.w, cache.h);
+    if (texture == NULL) {return NULL;}
+
+    if (cache.blend == SDL_BLENDMODE_INVALID) {
+        cache.blend = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                 SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+        if (SDL_SetTextureBlendMode(texture, cache.blend) < 0) {cache.blend = SDL_BLENDMODE_BLEND;}
+    }
+
+    SDL_SetTextureBlendMode(texture, cache.blend);
+    return texture;
+}
+
+// the strip holding row key, or NULL if every strip is already in use this frame (draw
+// the row directly then). redraw is set when the strip doesn't hold this signature yet,
+// in which case the caller has to clear it and draw the row into it
+SDL_Texture* row_cache_get(row_cache& cache, SDL_Renderer* renderer, int key, Uint64 signature, bool& redraw) {
+    row_strip* found = NULL;
+    for (row_strip& strip: cache.strips) {
+        if (strip.key == key) {found = &strip; break;}
+    }
+
+    if (found == NULL && cache.strips.size() < cache.capacity) {
+        SDL_Texture* texture = row_cache_create(cache, renderer);
+        if (texture != NULL) {
+            cache.strips.emplace_back();
+            found = &cache.strips.back();
+            found->texture = texture;
+        }
+    }
+
+    if (found == NULL) {
+        for (row_strip& strip: cache.strips) {
+            if (strip.last_used == cache.frame) {continue;}
+            if (found == NULL || strip.last_used < found->last_used) {found = &strip;}
+        }
+        if (found == NULL) {return NULL;}
+    }
+
+    redraw = found->key != key || found->signature != signature;
+    found->key = key;
+    found->signature = signature;
+    found->last_used = cache.frame;
+    return found->texture;
+}
+
+#endif
@@ -0,0 +1,78 @@
+// Smooth scrolling for the app list. The scroll position is a fractional
+// pixel offset that follows a target position on a critically damped spring,
+// stepped by real frame time, so it glides the same way at any refresh rate
+// and settles without overshooting. Wheel notches move the target; notches
+// that come in quick succession in the same direction move it further each
+// time, so flicking the wheel covers long lists quickly. Once the position is
+// close enough it snaps onto the target and stops, so an idle list costs
+// nothing.
+
+#ifndef SHANNON_SCROLLER_H
+#define SHANNON_SCROLLER_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+
+const float SCROLL_STIFFNESS = 18;      // 1/seconds; higher settles faster
+const Uint32 SCROLL_FLICK_MS = 150;     // notches closer together than this build up speed
+const float SCROLL_FLICK_MAX = 4;       // ...up to this many times the normal step
+
+struct scroller {
+    float pos = 0;          // pixels from the top of the list
+    float target = 0;
+    float velocity = 0;     // pixels per second
+    float max = 0;          // furthest pos can go
+
+    // flick acceleration
+    Uint32 last_input = 0;
+    float last_direction = 0;
+    float streak = 1;
+};
+
+void scroll_set_range(scroller& scroll, float max) {
+    scroll.max = std::max(0.f, max);
+    scroll.target = std::clamp(scroll.target, 0.f, scroll.max);
+    scroll.pos = std::clamp(scroll.pos, 0.f, scroll.max);
+}
+
+// moves the target by pixels (negative is up), speeding up for rapid repeats
+void scroll_by(scroller& scroll, float pixels, Uint32 now) {
+    float direction = pixels < 0 ? -1 : 1;
+    bool repeat = direction == scroll.last_direction && now - scroll.last_input < SCROLL_FLICK_MS;
+    scroll.streak = repeat ? std::min(scroll.streak + 0.5f, SCROLL_FLICK_MAX) : 1;
+    scroll.last_input = now;
+    scroll.last_direction = direction;
+
+    scroll.target = std::clamp(scroll.target + pixels * scroll.streak, 0.f, scroll.max);
+}
+
+// goes straight to pos, e.g. back to the top when the list's contents change
+void scroll_jump(scroller& scroll, float pos) {
+    scroll.pos = scroll.target = std::clamp(pos, 0.f, scroll.max);
+    scroll.velocity = 0;
+}
+
+bool scroll_moving(const scroller& scroll) {
+    return scroll.pos != scroll.target || scroll.velocity != 0;
+}
+
+// advances the spring by dt seconds. this is the spring's exact solution rather than a
+// numeric step, so it's stable however long a frame took
+void scroll_update(scroller& scroll, float dt) {
+    if (!scroll_moving(scroll)) {return;}
+
+    float offset = scroll.pos - scroll.target;
+    float decay = expf(-SCROLL_STIFFNESS * dt);
+    float temp = (scroll.velocity + SCROLL_STIFFNESS * offset) * dt;
+
+    scroll.velocity = (scroll.velocity - SCROLL_STIFFNESS * temp) * decay;
+    scroll.pos = scroll.target + (offset + temp) * decay;
+
+    if (fabsf(scroll.pos - scroll.target) < 0.25f && fabsf(scroll.velocity) < 2) {
+        scroll.pos = scroll.target;
+        scroll.velocity = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,146 @@
+// Type-to-filter search over the app list. Apps are searched by filename, name
+// and bundle ID straight from the app store's string arena, ignoring ASCII
+// case, and a trigram -> app postings index over those fields narrows each
+// query down to a handful of candidates before the substring check. Queries
+// that extend the previous one only re-check the previous matches, so typing a
+// word character by character stays cheap. Apps can be indexed and unindexed
+// one at a time as the store changes.
+
+#ifndef SHANNON_SEARCH_H
+#define SHANNON_SEARCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "app_store.h"
+
+const int SEARCH_FIELDS = 3;
+
+struct search_index {
+    std::vector<Uint32> app_store::* fields[SEARCH_FIELDS] = {&app_store::filename, &app_store::name, &app_store::bundle_id};
+    std::unordered_map<uint32_t, std::vector<int>> trigrams;   // postings are sorted app indices
+
+    std::string last_query;
+    std::vector<int> last_result;
+};
+
+char search_fold(char c) {
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+// ASCII-only on purpose: multi-byte UTF-8 sequences pass through untouched
+std::string search_lower(const std::string& str) {
+    std::string out = str;
+    for (char& c: out) {c = search_fold(c);}
+    return out;
+}
+
+uint32_t search_trigram(const char* str) {
+    return ((uint32_t)(unsigned char)search_fold(str[0]) << 16) | ((uint32_t)(unsigned char)search_fold(str[1]) << 8) |
+           (unsigned char)search_fold(str[2]);
+}
+
+// true if text contains needle, which is already lowercase
+bool search_contains(const char* text, const std::string& needle) {
+    for (; *text != '\0'; text++) {
+        size_t c = 0;
+        while (c < needle.size() && search_fold(text[c]) == needle[c]) {c++;}
+        if (c == needle.size()) {return true;}
+    }
+    return needle.empty();
+}
+
+// adds app i's fields to the postings
+void search_add(search_index& index, const app_store& store, int i) {
+    for (auto field: index.fields) {
+        const char* text = store_str(store, (store.*field)[i]);
+        for (size_t c = 0, len = strlen(text); c + 3 <= len; c++) {
+            std::vector<int>& postings = index.trigrams[search_trigram(text + c)];
+            auto pos = std::lower_bound(postings.begin(), postings.end(), i);
+            if (pos == postings.end() || *pos != i) {postings.insert(pos, i);}
+        }
+    }
+    index.last_query.clear();
+}
+
+// takes app i out of the postings; call it before i's fields change
+void search_remove(search_index& index, const app_store& store, int i) {
+    for (auto field: index.fields) {
+        const char* text = store_str(store, (store.*field)[i]);
+        for (size_t c = 0, len = strlen(text); c + 3 <= len; c++) {
+            auto found = index.trigrams.find(search_trigram(text + c));
+            if (found == index.trigrams.end()) {continue;}
+
+            std::vector<int>& postings = found->second;
+            auto pos = std::lower_bound(postings.begin(), postings.end(), i);
+            if (pos != postings.end() && *pos == i) {postings.erase(pos);}
+            if (postings.empty()) {index.trigrams.erase(found);}
+        }
+    }
+    index.last_query.clear();
+}
+
+void search_build(search_index& index, const app_store& store) {
+    index.trigrams.clear();
+    for (int i = 0; i < store.count; i++) {search_add(index, store, i);}
+}
+
+void search_run(search_index& index, const app_store& store, const std::string& query, std::vector<int>& out) {
+    std::string needle = search_lower(query);
+    int count = store.count;
+    out.clear();
+
+    if (needle.empty()) {
+        out.resize(count);
+        for (int i = 0; i < count; i++) {out[i] = i;}
+        index.last_query.clear();
+        return;
+    }
+
+    std::vector<int> candidates;
+    bool all = false;
+
+    if (!index.last_query.empty() && needle.compare(0, index.last_query.size(), index.last_query) == 0) {
+        // anything matching the longer query also matched the shorter one
+        candidates.swap(index.last_result);
+    } else if (needle.size() >= 3) {
+        // intersect postings, starting from the rarest trigram
+        std::vector<const std::vector<int>*> lists;
+        for (size_t c = 0; c + 3 <= needle.size(); c++) {
+            auto found = index.trigrams.find(search_trigram(&needle[c]));
+            if (found == index.trigrams.end()) {
+                index.last_query = needle;
+                index.last_result.clear();
+                return;
+            }
+            lists.push_back(&found->second);
+        }
+
+        std::sort(lists.begin(), lists.end(), [](auto a, auto b) {return a->size() < b->size();});
+        candidates = *lists[0];
+
+        for (size_t l = 1; l < lists.size() && !candidates.empty(); l++) {
+            std::vector<int> narrowed;
+            std::set_intersection(candidates.begin(), candidates.end(), lists[l]->begin(), lists[l]->end(), std::back_inserter(narrowed));
+            candidates.swap(narrowed);
+        }
+    } else {
+        all = true;
+    }
+
+    // trigrams can match out of order, so every candidate still gets a real substring check
+    int total = all ? count : candidates.size();
+    for (int c = 0; c < total; c++) {
+        int i = all ? c : candidates[c];
+        for (auto field: index.fields) {
+            if (search_contains(store_str(store, (store.*field)[i]), needle)) {out.push_back(i); break;}
+        }
+    }
+
+    index.last_query = needle;
+    index.last_result = out;
+}
+
+#endif
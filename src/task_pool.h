@@ -0,0 +1,83 @@
+// Minimal worker thread pool. Tasks may push more tasks (directory traversal
+// pushes a task per subdirectory and per IPA it finds), and pool_wait_idle()
+// returns once nothing is queued or running.
+
+#ifndef SHANNON_TASK_POOL_H
+#define SHANNON_TASK_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct task_pool {
+    std::mutex lock;
+    std::condition_variable wake;   // workers wait on this for new tasks
+    std::condition_variable idle;   // signalled when pending drops to 0
+    std::deque<std::function<void()>> tasks;
+    int pending = 0;                // queued + running
+    bool stopping = false;
+    std::vector<std::thread> threads;
+};
+
+void pool_worker(task_pool& pool) {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(pool.lock);
+            pool.wake.wait(guard, [&] {return pool.stopping || !pool.tasks.empty();});
+            if (pool.tasks.empty()) {return;}
+
+            task = std::move(pool.tasks.front());
+            pool.tasks.pop_front();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> guard(pool.lock);
+        if (--pool.pending == 0) {pool.idle.notify_all();}
+    }
+}
+
+void pool_start(task_pool& pool, int threads) {
+    pool.stopping = false;
+    for (int i = 0; i < threads; i++) {
+        pool.threads.emplace_back(pool_worker, std::ref(pool));
+    }
+}
+
+// urgent tasks jump the queue, e.g. directory listings so discovery stays ahead of extraction
+void pool_push(task_pool& pool, std::function<void()> task, bool urgent = false) {
+    {
+        std::lock_guard<std::mutex> guard(pool.lock);
+        if (urgent) {pool.tasks.push_front(std::move(task));}
+        else {pool.tasks.push_back(std::move(task));}
+        pool.pending++;
+    }
+    pool.wake.notify_one();
+}
+
+void pool_wait_idle(task_pool& pool) {
+    std::unique_lock<std::mutex> guard(pool.lock);
+    pool.idle.wait(guard, [&] {return pool.pending == 0;});
+}
+
+void pool_stop(task_pool& pool) {
+    {
+        std::lock_guard<std::mutex> guard(pool.lock);
+        pool.stopping = true;
+    }
+    pool.wake.notify_all();
+
+    for (auto& thread: pool.threads) {thread.join();}
+    pool.threads.clear();
+}
+
+int pool_default_threads() {
+    int threads = std::thread::hardware_concurrency();
+    return threads > 0 ? threads : 4;
+}
+
+#endif
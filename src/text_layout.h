@@ -0,0 +1,130 @@
+// Cached text layouts for draw_text(). Working out where each glyph of a
+// string goes (shrinking it to fit max_width, aligning it) happens once per
+// (text, scale, align, max_width); the result is kept as ready-made quads
+// relative to the text's origin. Drawing a cached string is then just copying
+// its vertices into a reused batch buffer, moved to the right place and
+// tinted, and handing the lot to SDL_RenderGeometry in one draw call.
+//
+// Layouts are looked up by a hash so a hit allocates nothing; the text is
+// kept alongside to rule out collisions. Each layout also remembers the glyph
+// atlas cells it uses and the atlas generation it was made in, and is redone
+// if the atlas has evicted anything since. The cache is emptied when the
+// window is resized (most layouts depend on its width), when it moves to a
+// display of a different density (glyphs are rasterised per real pixel size)
+// and when it fills up.
+
+#ifndef SHANNON_TEXT_LAYOUT_H
+#define SHANNON_TEXT_LAYOUT_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+const size_t TEXT_CACHE_MAX = 4096;
+
+struct text_layout {
+    std::string text;
+    int scale = 1, align = 1, max_width = 0;
+    std::vector<SDL_Vertex> vertices;   // 4 per glyph: top left, top right, bottom left, bottom right
+    std::vector<int> glyphs;            // atlas cell of each glyph
+    Uint32 generation = 0;              // atlas generation the cells were valid in
+    SDL_FRect bounds = {0, 0, 0, 0};    // relative to the origin, for skipping text that's off screen
+    float width = 0;                    // the whole string's advance, trailing spaces included
+};
+
+struct text_cache {
+    std::unordered_map<Uint64, text_layout> layouts;
+    std::vector<SDL_Vertex> batch;
+    std::vector<int> indices;           // the same two triangles per quad, grown as needed
+};
+
+Uint64 text_key(std::string_view text, int scale, int align, int max_width) {
+    Uint64 hash = 14695981039346656037ull;
+    for (char c: text) {hash = (hash ^ (Uint8)c) * 1099511628211ull;}
+    for (int value: {scale, align, max_width}) {hash = (hash ^ (Uint32)value) * 1099511628211ull;}
+    return hash;
+}
+
+void text_cache_clear(text_cache& cache) {
+    cache.layouts.clear();
+}
+
+// the cached layout for these parameters, or NULL
+const text_layout* text_find(text_cache& cache, Uint64 key, std::string_view text, int scale, int align, int max_width, Uint32 generation) {
+    auto found = cache.layouts.find(key);
+    if (found == cache.layouts.end()) {return NULL;}
+
+    const text_layout& layout = found->second;
+    if (layout.text != text || layout.scale != scale || layout.align != align || layout.max_width != max_width) {return NULL;}
+    if (layout.generation != generation) {return NULL;}
+    return &layout;
+}
+
+// a fresh, empty layout to fill in for these parameters
+text_layout& text_insert(text_cache& cache, Uint64 key, std::string_view text, int scale, int align, int max_width) {
+    if (cache.layouts.size() >= TEXT_CACHE_MAX) {text_cache_clear(cache);}
+
+    text_layout& layout = cache.layouts[key];
+    layout.text = text;
+    layout.scale = scale;
+    layout.align = align;
+    layout.max_width = max_width;
+    layout.vertices.clear();
+    layout.glyphs.clear();
+    layout.bounds = {0, 0, 0, 0};
+    layout.width = 0;
+    return layout;
+}
+
+// adds a glyph: dest relative to the text's origin, src in texture coordinates (0-1)
+void text_add_quad(text_layout& layout, SDL_FRect dest, SDL_FRect src, int glyph) {
+    layout.glyphs.push_back(glyph);
+    SDL_Color white = {255, 255, 255, 255};
+    layout.vertices.push_back({{dest.x, dest.y}, white, {src.x, src.y}});
+    layout.vertices.push_back({{dest.x + dest.w, dest.y}, white, {src.x + src.w, src.y}});
+    layout.vertices.push_back({{dest.x, dest.y + dest.h}, white, {src.x, src.y + src.h}});
+    layout.vertices.push_back({{dest.x + dest.w, dest.y + dest.h}, white, {src.x + src.w, src.y + src.h}});
+
+    if (layout.vertices.size() == 4) {
+        layout.bounds = dest;
+    } else {
+        float right = std::max(layout.bounds.x + layout.bounds.w, dest.x + dest.w);
+        float bottom = std::max(layout.bounds.y + layout.bounds.h, dest.y + dest.h);
+        layout.bounds.x = std::min(layout.bounds.x, dest.x);
+        layout.bounds.y = std::min(layout.bounds.y, dest.y);
+        layout.bounds.w = right - layout.bounds.x;
+        layout.bounds.h = bottom - layout.bounds.y;
+    }
+}
+
+// draws layout at x, y in one call. returns false if there was nothing on screen to draw
+bool text_draw(text_cache& cache, SDL_Renderer* renderer, SDL_Texture* texture, const text_layout& layout,
+               float x, float y, SDL_Color color, int view_w, int view_h) {
+    if (layout.vertices.empty()) {return false;}
+    if (x + layout.bounds.x > view_w || x + layout.bounds.x + layout.bounds.w < 0 ||
+        y + layout.bounds.y > view_h || y + layout.bounds.y + layout.bounds.h < 0) {return false;}
+
+    size_t count = layout.vertices.size();
+    cache.batch.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        SDL_Vertex& vertex = cache.batch[i];
+        vertex = layout.vertices[i];
+        vertex.position.x += x;
+        vertex.position.y += y;
+        vertex.color = color;
+    }
+
+    size_t quads = count / 4;
+    for (size_t q = cache.indices.size() / 6; q < quads; q++) {
+        int base = q * 4;
+        cache.indices.insert(cache.indices.end(), {base, base + 1, base + 2, base + 2, base + 1, base + 3});
+    }
+
+    SDL_RenderGeometry(renderer, texture, cache.batch.data(), count, cache.indices.data(), quads * 6);
+    return true;
+}
+
+#endif
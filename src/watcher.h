@@ -0,0 +1,319 @@
+// Watches a directory tree for added, removed, renamed and modified files with
+// a given extension. Uses inotify on Linux; everywhere else (or if inotify
+// can't be set up) it falls back to diffing directory snapshots on a timer.
+// Snapshots walk and stat the whole tree, which can take a while on big or
+// network libraries, so given a task pool they're taken there and picked up
+// by a later poll. A caller that has just listed the tree itself can hand
+// that over as the first snapshot with watcher_seed(), so nothing that changes
+// between its listing and the watcher starting is missed. Reported names are
+// paths relative to the watched directory, '/'-separated.
+
+#ifndef SHANNON_WATCHER_H
+#define SHANNON_WATCHER_H
+
+#include <SDL2/SDL.h>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+#include "task_pool.h"
+
+enum watch_change_type {
+    WATCH_ADDED,
+    WATCH_REMOVED,
+    WATCH_MODIFIED,
+    WATCH_RENAMED,
+    WATCH_RESCAN   // events were lost, the whole directory should be rescanned
+};
+
+struct watch_change {
+    watch_change_type type;
+    std::string name;       // relative to the watched directory
+    std::string old_name;   // WATCH_RENAMED only
+};
+
+struct file_stamp {
+    std::uintmax_t size = 0;
+    std::filesystem::file_time_type mtime;
+
+    bool operator==(const file_stamp& other) const {return size == other.size && mtime == other.mtime;}
+    bool operator!=(const file_stamp& other) const {return !(*this == other);}
+};
+
+// a snapshot being taken in the background; shared with the task so the watcher can go away first
+struct watch_snapshot_job {
+    std::mutex lock;
+    bool done = false;
+    std::map<std::string, file_stamp> files;
+};
+
+struct dir_watcher {
+    std::filesystem::path dir;
+    std::string extension;
+
+    int fd = -1;    // inotify descriptor, -1 when polling
+    std::map<int, std::string> watch_dirs;  // inotify watch -> relative subdirectory ("" for the root)
+
+    // polling fallback: files are only reported once they've stopped changing
+    // between two polls, so half-copied IPAs don't get picked up early
+    Uint32 poll_interval = 2000;       // between the end of one snapshot and the start of the next
+    Uint32 last_poll = 0;
+    std::map<std::string, file_stamp> known;
+    std::map<std::string, file_stamp> pending;
+    bool have_known = false;            // the first snapshot only sets known, unless it's seeded
+    task_pool* pool = NULL;             // where snapshots are taken, or NULL for right away
+    std::shared_ptr<watch_snapshot_job> job;
+};
+
+std::string watcher_relative(const dir_watcher& watcher, const std::filesystem::path& path) {
+    return path.lexically_relative(watcher.dir).generic_string();
+}
+
+// worker-safe: only reads its arguments
+std::map<std::string, file_stamp> watcher_snapshot(const std::filesystem::path& dir, const std::string& extension) {
+    std::map<std::string, file_stamp> snapshot;
+    std::error_code err;
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+
+    for (auto& entry: std::filesystem::recursive_directory_iterator(dir, options, err)) {
+        if (entry.path().extension() != extension) {continue;}
+
+        file_stamp stamp;
+        stamp.size = entry.file_size(err);
+        stamp.mtime = entry.last_write_time(err);
+        if (err) {continue;}
+
+        snapshot[entry.path().lexically_relative(dir).generic_string()] = stamp;
+    }
+
+    return snapshot;
+}
+
+void watcher_start_snapshot(dir_watcher& watcher) {
+    auto job = std::make_shared<watch_snapshot_job>();
+    watcher.job = job;
+
+    std::filesystem::path dir = watcher.dir;
+    std::string extension = watcher.extension;
+    auto task = [job, dir, extension] {
+        std::map<std::string, file_stamp> files = watcher_snapshot(dir, extension);
+        std::lock_guard<std::mutex> guard(job->lock);
+        job->files.swap(files);
+        job->done = true;
+    };
+
+    if (watcher.pool != NULL) {pool_push(*watcher.pool, task);}
+    else {task();}
+}
+
+#ifdef __linux__
+// watches subdir and everything under it; reports IPAs already inside as added,
+// since they may have landed before the watch was in place
+void watcher_add_tree(dir_watcher& watcher, const std::string& subdir, std::vector<watch_change>* changes) {
+    std::filesystem::path root = watcher.dir / subdir;
+    Uint32 mask = IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE;
+
+    int wd = inotify_add_watch(watcher.fd, root.string().c_str(), mask);
+    if (wd < 0) {return;}
+    watcher.watch_dirs[wd] = subdir;
+
+    std::error_code err;
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+    for (auto& entry: std::filesystem::recursive_directory_iterator(root, options, err)) {
+        std::string name = watcher_relative(watcher, entry.path());
+
+        if (entry.is_directory(err) && !entry.is_symlink(err)) {
+            wd = inotify_add_watch(watcher.fd, entry.path().string().c_str(), mask);
+            if (wd >= 0) {watcher.watch_dirs[wd] = name;}
+        } else if (changes != NULL && entry.path().extension() == watcher.extension) {
+            changes->push_back({WATCH_ADDED, name, ""});
+        }
+    }
+}
+#endif
+
+// pool, if given, takes the polling fallback's snapshots and must outlive the watcher's use.
+// seeded means the first snapshot will come from watcher_seed(), so none is taken until then
+void watcher_open(dir_watcher& watcher, const std::filesystem::path& dir, const std::string& extension, task_pool* pool = NULL, bool seeded = false) {
+    watcher.dir = dir;
+    watcher.extension = extension;
+    watcher.pool = pool;
+
+#ifdef __linux__
+    // files are reported on IN_CLOSE_WRITE rather than IN_CREATE/IN_MODIFY so we only hear
+    // about finished copies; IN_CREATE is only used to start watching new subdirectories
+    watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher.fd >= 0) {
+        watcher_add_tree(watcher, "", NULL);
+        if (!watcher.watch_dirs.empty()) {return;}
+
+        close(watcher.fd);
+        watcher.fd = -1;
+    }
+    printf("[!] inotify unavailable for %s, polling instead\n", dir.string().c_str());
+#endif
+
+    watcher.have_known = false;
+    if (!seeded) {watcher_start_snapshot(watcher);}
+}
+
+// files (relative names, as reported) as they were when the caller listed them; polling
+// reports whatever differs from this next. inotify watchers don't need it
+void watcher_seed(dir_watcher& watcher, std::map<std::string, file_stamp> files) {
+    if (watcher.fd >= 0) {return;}
+    watcher.known.swap(files);
+    watcher.pending.clear();
+    watcher.have_known = true;
+    watcher.job.reset();
+    watcher.last_poll = SDL_GetTicks();
+}
+
+void watcher_close(dir_watcher& watcher) {
+#ifdef __linux__
+    if (watcher.fd >= 0) {close(watcher.fd);}
+#endif
+    watcher.fd = -1;
+    watcher.watch_dirs.clear();
+    watcher.known.clear();
+    watcher.pending.clear();
+    watcher.have_known = false;
+    watcher.job.reset();   // a snapshot still running finishes into nothing
+}
+
+bool watcher_matches(const dir_watcher& watcher, const std::string& name) {
+    return std::filesystem::path(name).extension() == watcher.extension;
+}
+
+#ifdef __linux__
+void watcher_read_inotify(dir_watcher& watcher, std::vector<watch_change>& changes) {
+    alignas(inotify_event) char buf[8192];
+    // IN_MOVED_FROM waiting for its IN_MOVED_TO, keyed by cookie
+    std::map<Uint32, std::string> moved_from;
+
+    while (true) {
+        ssize_t len = read(watcher.fd, buf, sizeof(buf));
+        if (len <= 0) {break;}
+
+        for (char* ptr = buf; ptr < buf + len; ) {
+            inotify_event* evt = (inotify_event*)ptr;
+            ptr += sizeof(inotify_event) + evt->len;
+
+            if (evt->mask & IN_Q_OVERFLOW) {
+                changes.push_back({WATCH_RESCAN, "", ""});
+                continue;
+            }
+
+            if (evt->mask & IN_IGNORED) {
+                watcher.watch_dirs.erase(evt->wd);
+                continue;
+            }
+
+            auto dir = watcher.watch_dirs.find(evt->wd);
+            if (evt->len == 0 || dir == watcher.watch_dirs.end()) {continue;}
+            std::string name = dir->second.empty() ? evt->name : dir->second + "/" + evt->name;
+
+            if (evt->mask & IN_ISDIR) {
+                // new or moved-in directories get watched and their contents reported;
+                // a directory moving away takes an unknown number of apps with it
+                if (evt->mask & (IN_CREATE | IN_MOVED_TO)) {watcher_add_tree(watcher, name, &changes);}
+                else if (evt->mask & IN_MOVED_FROM) {changes.push_back({WATCH_RESCAN, "", ""});}
+                continue;
+            }
+
+            if (evt->mask & IN_MOVED_FROM) {
+                if (watcher_matches(watcher, name)) {moved_from[evt->cookie] = name;}
+            } else if (evt->mask & IN_MOVED_TO) {
+                if (!watcher_matches(watcher, name)) {continue;}
+
+                auto from = moved_from.find(evt->cookie);
+                if (from != moved_from.end()) {
+                    changes.push_back({WATCH_RENAMED, name, from->second});
+                    moved_from.erase(from);
+                } else {
+                    changes.push_back({WATCH_ADDED, name, ""});
+                }
+            } else if (evt->mask & IN_DELETE) {
+                if (watcher_matches(watcher, name)) {changes.push_back({WATCH_REMOVED, name, ""});}
+            } else if (evt->mask & IN_CLOSE_WRITE) {
+                if (watcher_matches(watcher, name)) {changes.push_back({WATCH_MODIFIED, name, ""});}
+            }
+        }
+    }
+
+    // moved out of the directory (or renamed to a different extension)
+    for (auto& from: moved_from) {
+        changes.push_back({WATCH_REMOVED, from.second, ""});
+    }
+}
+#endif
+
+void watcher_diff_snapshot(dir_watcher& watcher, std::vector<watch_change>& changes) {
+    if (watcher.job == NULL && !watcher.have_known) {return;}    // waiting for watcher_seed()
+    if (watcher.job == NULL) {
+        if (SDL_GetTicks() - watcher.last_poll < watcher.poll_interval) {return;}
+        watcher_start_snapshot(watcher);
+    }
+
+    std::map<std::string, file_stamp> snapshot;
+    {
+        std::lock_guard<std::mutex> guard(watcher.job->lock);
+        if (!watcher.job->done) {return;}
+        snapshot.swap(watcher.job->files);
+    }
+    watcher.job.reset();
+    watcher.last_poll = SDL_GetTicks();
+
+    if (!watcher.have_known) {
+        watcher.known.swap(snapshot);
+        watcher.have_known = true;
+        return;
+    }
+
+    for (auto it = watcher.known.begin(); it != watcher.known.end(); ) {
+        if (snapshot.find(it->first) == snapshot.end()) {
+            changes.push_back({WATCH_REMOVED, it->first, ""});
+            it = watcher.known.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::map<std::string, file_stamp> still_changing;
+    for (auto& file: snapshot) {
+        auto known = watcher.known.find(file.first);
+        if (known != watcher.known.end() && known->second == file.second) {continue;}
+
+        auto pending = watcher.pending.find(file.first);
+        if (pending == watcher.pending.end() || pending->second != file.second) {
+            still_changing[file.first] = file.second;
+            continue;
+        }
+
+        changes.push_back({known == watcher.known.end() ? WATCH_ADDED : WATCH_MODIFIED, file.first, ""});
+        watcher.known[file.first] = file.second;
+    }
+    watcher.pending = still_changing;
+}
+
+// appends whatever changed since the last call; cheap enough to call every frame
+void watcher_poll(dir_watcher& watcher, std::vector<watch_change>& changes) {
+#ifdef __linux__
+    if (watcher.fd >= 0) {
+        watcher_read_inotify(watcher, changes);
+        return;
+    }
+#endif
+    watcher_diff_snapshot(watcher, changes);
+}
+
+#endif
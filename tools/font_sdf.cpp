@@ -0,0 +1,103 @@
+/*
+*   This program/source code is licensed under the MIT License:
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+*/
+
+// Build step that turns the bitmap font in src/font.h into a signed distance
+// field, written to stdout as src/font_sdf.h. The Makefile runs it before
+// building Shannon; see glyph_atlas.h for how the field is used.
+//
+// Each font pixel is treated as a solid square, and every sample stores the
+// exact distance from its centre to the edge of the glyph: positive inside,
+// negative outside. Straight edges survive linear interpolation exactly, so
+// the glyphs stay sharp at any size instead of growing blocky or blurry.
+//
+// usage: font_sdf > src/font_sdf.h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "../src/font.h"
+
+const int GLYPHS = 95;              // printable ASCII, from ' '
+const int SCALE = 3;                // samples per font pixel, each way; odd so one lands on each pixel centre
+const float SPREAD = 2;             // distances are clamped to this many font pixels
+
+int char_w, char_h;
+
+bool solid(int glyph, int x, int y) {
+    if (x < 0 || y < 0 || x >= char_w || y >= char_h) {return false;}
+    int i = (y * fallback_font.width + glyph * char_w + x) * fallback_font.bytes_per_pixel;
+    return fallback_font.pixel_data[i + 3] >= 128;
+}
+
+// distance from a point to the font pixel x, y, in font pixels
+float square_distance(float px, float py, int x, int y) {
+    float dx = std::max({x - px, 0.f, px - (x + 1)});
+    float dy = std::max({y - py, 0.f, py - (y + 1)});
+    return sqrtf(dx * dx + dy * dy);
+}
+
+// signed distance from a point to the glyph's edge: the nearest pixel of the other kind
+float signed_distance(int glyph, float px, float py) {
+    bool inside = solid(glyph, (int)floorf(px), (int)floorf(py));
+    int reach = (int)ceilf(SPREAD) + 1;
+    float nearest = SPREAD;
+
+    for (int y = (int)floorf(py) - reach; y <= (int)floorf(py) + reach; y++) {
+        for (int x = (int)floorf(px) - reach; x <= (int)floorf(px) + reach; x++) {
+            if (solid(glyph, x, y) != inside) {nearest = std::min(nearest, square_distance(px, py, x, y));}
+        }
+    }
+    return inside ? nearest : -nearest;
+}
+
+int main() {
+    char_w = fallback_font.width / GLYPHS;
+    char_h = fallback_font.height;
+    int w = fallback_font.width * SCALE;
+    int h = fallback_font.height * SCALE;
+
+    printf("// Generated from src/font.h by tools/font_sdf.cpp; don't edit, run make instead.\n");
+    printf("// The bitmap font as a signed distance field: one byte per sample, 128 on the\n");
+    printf("// glyph's edge and FONT_SDF_SPREAD font pixels per 127 steps either side.\n\n");
+    printf("#ifndef SHANNON_FONT_SDF_H\n#define SHANNON_FONT_SDF_H\n\n");
+    printf("const int FONT_SDF_CHAR_W = %d;\n", char_w);
+    printf("const int FONT_SDF_CHAR_H = %d;\n", char_h);
+    printf("const int FONT_SDF_SCALE = %d;\n", SCALE);
+    printf("const float FONT_SDF_SPREAD = %g;\n", SPREAD);
+    printf("const int FONT_SDF_W = %d;\n", w);
+    printf("const int FONT_SDF_H = %d;\n\n", h);
+    printf("static const unsigned char font_sdf[%d] = {\n", w * h);
+
+    for (int y = 0; y < h; y++) {
+        printf("   ");
+        for (int x = 0; x < w; x++) {
+            float distance = signed_distance(x / (char_w * SCALE), (float)(x % (char_w * SCALE) + 0.5f) / SCALE, (y + 0.5f) / SCALE);
+            int value = (int)lroundf(128 + distance * 127 / SPREAD);
+            printf(" %d,", std::clamp(value, 0, 255));
+        }
+        printf("\n");
+    }
+
+    printf("};\n\n#endif\n");
+    return 0;
+}
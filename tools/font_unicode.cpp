@@ -0,0 +1,113 @@
+/*
+*   This program/source code is licensed under the MIT License:
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+*/
+
+// Build step that turns the bitmap font in res/font_unicode.hex into
+// src/font_unicode.h, written to stdout. The Makefile runs it before building
+// Shannon; glyph_atlas.h draws characters outside ASCII from it.
+//
+// Glyphs are sorted by code point for binary search. Every glyph is 16 rows of
+// 16 bits, leftmost pixel in the top bit; narrow glyphs only use the top 8.
+//
+// usage: font_unicode res/font_unicode.hex > src/font_unicode.h
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+const int ROWS = 16;
+
+struct glyph {
+    unsigned int code;
+    int width;
+    unsigned short rows[ROWS];
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: font_unicode <font.hex>\n");
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "r");
+    if (file == NULL) {
+        fprintf(stderr, "[!] Couldn't open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<glyph> glyphs;
+    char line[256];
+    for (int number = 1; fgets(line, sizeof(line), file) != NULL; number++) {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {continue;}
+
+        glyph g = {};
+        char bits[80] = "";
+        if (sscanf(line, "%x:%79[0-9A-Fa-f]", &g.code, bits) != 2) {
+            fprintf(stderr, "[!] %s:%d isn't a glyph\n", argv[1], number);
+            return 1;
+        }
+
+        int digits = strlen(bits) / ROWS;
+        if (strlen(bits) % ROWS != 0 || (digits != 2 && digits != 4)) {
+            fprintf(stderr, "[!] %s:%d isn't 8 or 16 pixels wide\n", argv[1], number);
+            return 1;
+        }
+        if (!glyphs.empty() && g.code <= glyphs.back().code) {
+            fprintf(stderr, "[!] %s:%d is out of order\n", argv[1], number);
+            return 1;
+        }
+
+        g.width = digits * 4;
+        for (int y = 0; y < ROWS; y++) {
+            unsigned int row = std::stoul(std::string(bits + y * digits, digits), NULL, 16);
+            g.rows[y] = row << (16 - g.width);
+        }
+        glyphs.push_back(g);
+    }
+    fclose(file);
+
+    int count = glyphs.size();
+    printf("// Generated from res/font_unicode.hex by tools/font_unicode.cpp; don't edit, run make instead.\n");
+    printf("// Bitmap glyphs for characters outside ASCII, sorted by code point: 16 rows of\n");
+    printf("// 16 bits each, leftmost pixel in the top bit, and 8 or 16 pixels wide.\n\n");
+    printf("#ifndef SHANNON_FONT_UNICODE_H\n#define SHANNON_FONT_UNICODE_H\n\n");
+    printf("const int FONT_UNICODE_ROWS = %d;\n", ROWS);
+    printf("const int FONT_UNICODE_GLYPHS = %d;\n\n", count);
+
+    printf("static const unsigned int font_unicode_codes[%d] = {", count);
+    for (int i = 0; i < count; i++) {printf("%s0x%X,", i % 12 == 0 ? "\n    " : " ", glyphs[i].code);}
+    printf("\n};\n\n");
+
+    printf("static const unsigned char font_unicode_widths[%d] = {", count);
+    for (int i = 0; i < count; i++) {printf("%s%d,", i % 32 == 0 ? "\n    " : " ", glyphs[i].width);}
+    printf("\n};\n\n");
+
+    printf("static const unsigned short font_unicode_rows[%d] = {\n", count * ROWS);
+    for (const glyph& g: glyphs) {
+        printf("   ");
+        for (int y = 0; y < ROWS; y++) {printf(" 0x%X,", g.rows[y]);}
+        printf("\n");
+    }
+    printf("};\n\n#endif\n");
+    return 0;
+}
@@ -0,0 +1,97 @@
+# Makes res/font_unicode.hex, the bitmap font draw_text() uses for characters
+# outside ASCII. It's only needed to change which characters the font covers; the
+# build reads the .hex file (see tools/font_unicode.cpp) and doesn't run this.
+#
+# Glyphs are rendered hinted and without antialiasing, in GNU Unifont's .hex format:
+# East Asian wide characters 16x16 from Droid Sans Fallback, and the rest 8x16 from
+# DejaVu Sans Mono (see res/font_unicode-LICENSE.txt for both licenses). Chinese, Japanese and Korean characters are limited to the national
+# standard sets (GB 2312, JIS X 0208, KS X 1001 and Big5's common hanzi), which
+# covers almost everything in practice at a fraction of the size.
+#
+# usage: python3 tools/font_unicode_hex.py DroidSansFallbackFull.ttf DejaVuSansMono.ttf > res/font_unicode.hex
+# needs Pillow and fontTools
+
+import sys
+from fontTools.ttLib import TTFont
+from PIL import Image, ImageDraw, ImageFont
+
+ROWS = 16
+WIDE_SIZE = 16
+WIDE_BASELINE = 14      # of 16 rows; CJK glyphs fill the em box, 0.88 em of which is above the baseline
+NARROW_SIZE = 14        # DejaVu Sans Mono's advance is 0.6 em, so this is 8 pixels
+NARROW_BASELINE = 14    # glyphs sit on the bottom of the cell, so this lines Latin up with the built-in font
+
+
+# must agree with glyph_wide() in src/glyph_atlas.h
+def wide(code):
+    return (0x1100 <= code <= 0x115F or (0x2E80 <= code <= 0xA4CF and code != 0x303F) or
+            0xAC00 <= code <= 0xD7A3 or 0xF900 <= code <= 0xFAFF or 0xFE30 <= code <= 0xFE4F or
+            0xFF00 <= code <= 0xFF60 or 0xFFE0 <= code <= 0xFFE6 or 0x1F300 <= code <= 0x1F64F or
+            0x1F900 <= code <= 0x1F9FF or 0x20000 <= code <= 0x3FFFD)
+
+
+# every character of a double-byte encoding with these lead and trail bytes
+def charset(codec, leads, trails):
+    codes = set()
+    for lead in leads:
+        for trail in trails:
+            try:
+                text = bytes([lead, trail]).decode(codec)
+            except UnicodeDecodeError:
+                continue
+            if len(text) == 1:
+                codes.add(ord(text))
+    return codes
+
+
+def wanted():
+    codes = set()
+    for first, last in [(0xA0, 0x24F), (0x370, 0x3FF), (0x400, 0x45F), (0x2010, 0x205E), (0x20A0, 0x20BF),
+                        (0x2100, 0x214F), (0x2190, 0x21FF), (0x3000, 0x30FF), (0x3130, 0x318F),
+                        (0xFF01, 0xFF9F), (0xFFE0, 0xFFE6)]:
+        codes.update(range(first, last + 1))
+
+    codes |= charset('gb2312', range(0xA1, 0xF8), range(0xA1, 0xFF))
+    codes |= charset('euc_jp', range(0xA1, 0xF5), range(0xA1, 0xFF))
+    codes |= charset('euc_kr', range(0xA1, 0xFE), range(0xA1, 0xFF))
+    codes |= charset('big5', range(0xA4, 0xC7), list(range(0x40, 0x7F)) + list(range(0xA1, 0xFF)))
+    return sorted(code for code in codes if code >= 0xA0)
+
+
+def main():
+    wide_cmap = TTFont(sys.argv[1]).getBestCmap()
+    narrow_cmap = TTFont(sys.argv[2]).getBestCmap()
+    wide_font = ImageFont.truetype(sys.argv[1], WIDE_SIZE)
+    narrow_font = ImageFont.truetype(sys.argv[2], NARROW_SIZE)
+
+    print('# Generated by tools/font_unicode_hex.py from Droid Sans Fallback and DejaVu Sans')
+    print('# Mono; see font_unicode-LICENSE.txt. GNU Unifont .hex format: code point, then')
+    print('# 16 rows of 8 or 16 pixels as 2 or 4 hex digits each, most significant bit leftmost.')
+
+    for code in wanted():
+        width = 16 if wide(code) else 8
+        font, cmap, baseline = (wide_font, wide_cmap, WIDE_BASELINE) if width == 16 else (narrow_font, narrow_cmap, NARROW_BASELINE)
+        if code not in cmap:
+            continue
+        advance = font.getlength(chr(code))
+        if advance == 0 or advance > width + 0.5:
+            continue    # combining marks, and symbols too wide for their columns
+
+        image = Image.new('L', (width, ROWS), 0)
+        draw = ImageDraw.Draw(image)
+        draw.fontmode = '1'
+        draw.text(((width - advance) / 2, baseline), chr(code), fill=255, font=font, anchor='ls')
+
+        pixels = image.load()
+        if not any(pixels[x, y] for y in range(ROWS) for x in range(width)) and code not in (0xA0, 0x3000):
+            continue    # nothing drawn, so better shown as a box
+        rows = ''
+        for y in range(ROWS):
+            bits = 0
+            for x in range(width):
+                bits = bits << 1 | (pixels[x, y] >= 128)
+            rows += '%0*X' % (width // 4, bits)
+        print('%04X:%s' % (code, rows))
+
+
+main()